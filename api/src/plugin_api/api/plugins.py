@@ -1,10 +1,16 @@
 """Endpoint that hosts binary plugins for all platforms and provides them to the client to download."""
 
+import json
 import os
 from io import BytesIO
 
 import hashlib
 
+try:
+    import blake3  # optional: without it catalogs carry "sha1:" digests
+except ImportError:
+    blake3 = None
+
 from pydantic import BaseModel
 
 from litestar.exceptions import NotFoundException
@@ -35,20 +41,26 @@ class Plugin(BaseModel):
     name: str
     size: int
     sha1: str
+    digest: str
     version: str
+    execution: str = "in-process"
 
     def __dict__(self):
         return {
             "name": self.name,
             "size": self.size,
             "sha1": self.sha1,
+            "digest": self.digest,
             "version": self.version,
+            "execution": self.execution,
         }
 
 
-def get_sha1(file_path) -> str:
+def get_digests(file_path) -> tuple[str, str]:
+    """SHA1 hex for older clients, and the algorithm-tagged digest clients verify against."""
     BUF_SIZE = 65536
     sha1 = hashlib.sha1()
+    tagged = blake3.blake3() if blake3 else None
 
     with open(file_path, "rb") as f:
         while True:
@@ -56,8 +68,22 @@ def get_sha1(file_path) -> str:
             if not data:
                 break
             sha1.update(data)
+            if tagged:
+                tagged.update(data)
+
+    if tagged:
+        return sha1.hexdigest(), "blake3:" + tagged.hexdigest()
+    return sha1.hexdigest(), "sha1:" + sha1.hexdigest()
+
+
+def get_execution(file_path) -> str:
+    """Execution mode from an optional `<plugin>.json` next to the plugin, e.g. {"execution": "worker"}."""
+    meta_path = file_path + ".json"
+    if not os.path.exists(meta_path):
+        return "in-process"
 
-    return sha1.hexdigest()
+    with open(meta_path) as f:
+        return json.load(f).get("execution", "in-process")
 
 
 REGISTRY_BASE_PATH = os.getenv("REGISTRY_BASE_PATH", os.path.abspath("./plugins"))
@@ -102,11 +128,14 @@ def get_plugin_list() -> dict:
                 if not os.path.isdir(os.path.join(arch_path, plugin_name)) and (
                     plugin_name.endswith(".plugin") or plugin_name.endswith(".plugin.wasm")
                 ):
+                    sha1, digest = get_digests(os.path.join(arch_path, plugin_name))
                     plugin = Plugin(
                         name=plugin_name,
                         size=os.path.getsize(os.path.join(arch_path, plugin_name)),
-                        sha1=get_sha1(os.path.join(arch_path, plugin_name)),
+                        sha1=sha1,
+                        digest=digest,
                         version=plugin_name,
+                        execution=get_execution(os.path.join(arch_path, plugin_name)),
                     )
                     plugins[arch].append(plugin)
     return plugins
@@ -0,0 +1,141 @@
+#include "lib/plugin_manager.h"
+#include "lib/plugin_digest.h"
+#include "lib/tiny_sha1.hpp"
+#include "lib/tiny_blake3.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static void BM_Sha1(benchmark::State &state)
+{
+    std::vector<char> data(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>(i * 131);
+    }
+
+    for (auto _ : state) {
+        sha1::SHA1 sha;
+        sha.processBytes(data.data(), data.size());
+        unsigned char digest[20];
+        sha.getDigestBytes(digest);
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sha1)->RangeMultiplier(8)->Range(64, 64 << 20);
+
+static std::vector<char> BenchBuffer(int64_t size)
+{
+    std::vector<char> data(static_cast<size_t>(size));
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>(i * 131);
+    }
+    return data;
+}
+
+// single-threaded tree hash, the baseline for the parallel digestHex below
+static void BM_Blake3(benchmark::State &state)
+{
+    std::vector<char> data = BenchBuffer(state.range(0));
+    for (auto _ : state) {
+        uint8_t digest[blake3::OUT_LEN];
+        blake3::hash(data.data(), data.size(), digest);
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Blake3)->RangeMultiplier(8)->Range(64, 64 << 20);
+
+static void BM_DigestHex(benchmark::State &state)
+{
+    DigestAlgorithm algorithm = static_cast<DigestAlgorithm>(state.range(0));
+    std::vector<char> data = BenchBuffer(state.range(1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(digestHex(algorithm, data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+    state.SetLabel(digestAlgorithmName(algorithm));
+}
+BENCHMARK(BM_DigestHex)
+    ->ArgsProduct({{int(DigestAlgorithm::Sha1), int(DigestAlgorithm::Blake3)}, {64 << 10, 4 << 20, 64 << 20}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// a download hashed in curl-sized pieces as it arrives
+static void BM_DigestStream(benchmark::State &state)
+{
+    DigestAlgorithm algorithm = static_cast<DigestAlgorithm>(state.range(0));
+    std::vector<char> data = BenchBuffer(state.range(1));
+    const size_t piece = 16 << 10;
+    for (auto _ : state) {
+        DigestStream digest(algorithm);
+        for (size_t offset = 0; offset < data.size(); offset += piece) {
+            digest.update(data.data() + offset, std::min(piece, data.size() - offset));
+        }
+        benchmark::DoNotOptimize(digest.finishHex());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+    state.SetLabel(digestAlgorithmName(algorithm));
+}
+BENCHMARK(BM_DigestStream)
+    ->ArgsProduct({{int(DigestAlgorithm::Sha1), int(DigestAlgorithm::Blake3)}, {64 << 10, 4 << 20, 64 << 20}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Files live in PLUGIN_BENCH_DIR (default: the working directory). Cold numbers
+// are only meaningful on a disk-backed filesystem; tmpfs ignores the eviction.
+static std::string BenchFile(int64_t size)
+{
+    const char* dir = std::getenv("PLUGIN_BENCH_DIR");
+    std::filesystem::path path = std::filesystem::path(dir ? dir : ".") / ("sha1_bench_" + std::to_string(size) + ".bin");
+    if (!std::filesystem::exists(path) || std::filesystem::file_size(path) != static_cast<uintmax_t>(size)) {
+        std::vector<char> data(static_cast<size_t>(size));
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<char>(i * 131);
+        }
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), size);
+    }
+    return path.string();
+}
+
+static void EvictFromPageCache(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static void BM_Sha1FileHexWarm(benchmark::State &state)
+{
+    std::string path = BenchFile(state.range(0));
+    benchmark::DoNotOptimize(sha1FileHex(path));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sha1FileHex(path));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sha1FileHexWarm)->RangeMultiplier(16)->Range(4 << 10, 64 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_Sha1FileHexCold(benchmark::State &state)
+{
+    std::string path = BenchFile(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        EvictFromPageCache(path);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(sha1FileHex(path));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sha1FileHexCold)->RangeMultiplier(16)->Range(4 << 10, 64 << 20)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,89 @@
+#include "lib/plugin_manager.h"
+#include "lib/event_bus.h"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include <string>
+
+static std::string MakeCatalog(int64_t entries)
+{
+    nlohmann::json catalog = nlohmann::json::array();
+    for (int64_t i = 0; i < entries; i++) {
+        catalog.push_back({
+            {"name", "plugin_" + std::to_string(i) + ".plugin"},
+            {"size", 250000 + i},
+            {"sha1", "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+            {"version", "1.0." + std::to_string(i)},
+        });
+    }
+    return catalog.dump();
+}
+
+static std::string SyntheticPlugin(int64_t symbols)
+{
+    return std::string(PLUGIN_BENCH_PLUGIN_DIR) + "/synthetic_" + std::to_string(symbols) + ".plugin";
+}
+
+static void BM_ParsePluginList(benchmark::State &state)
+{
+    std::string catalog = MakeCatalog(state.range(0));
+    auto& manager = PluginManager::getInstance();
+    for (auto _ : state) {
+        manager.parsePluginList(catalog);
+        benchmark::DoNotOptimize(manager.getPluginList().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(catalog.size()));
+    manager.getPluginList().clear();
+}
+BENCHMARK(BM_ParsePluginList)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// dlopen + pluginMain; natively this is all loadPluginFromFile does
+static void BM_LoadPluginFromFile(benchmark::State &state)
+{
+    auto& manager = PluginManager::getInstance();
+    std::string path = SyntheticPlugin(state.range(0));
+    for (auto _ : state) {
+        int ret = manager.openPlugin(path);
+
+        state.PauseTiming();
+        if (ret < 0) {
+            state.SkipWithError("could not load synthetic plugin");
+            break;
+        }
+        manager.unloadAll();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_LoadPluginFromFile)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
+
+// Tears down every synthetic plugin plus `range` ticks, prepared draws and event
+// subscriptions spread over them.
+static void BM_UnloadAll(benchmark::State &state)
+{
+    auto& manager = PluginManager::getInstance();
+    auto& bus = EventBus::getInstance();
+    const EventBus::TopicId topic = bus.topicId("bench.topic");
+    const int64_t symbolCounts[] = {10, 100, 1000, 10000};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int64_t symbols : symbolCounts) {
+            if (manager.openPlugin(SyntheticPlugin(symbols)) < 0) {
+                state.SkipWithError("could not load synthetic plugin");
+                return;
+            }
+        }
+        for (int64_t i = 0; i < state.range(0); i++) {
+            std::string owner = "synthetic_" + std::to_string(symbolCounts[i % 4]);
+            Scheduler::getInstance().registerTick(owner, 60.0, [](double) {});
+            DrawListComposer::getInstance().registerPrepared(owner, "bench", [](DrawBuffer&, ImVec2) { return false; });
+            bus.subscribe(owner, topic, [](const SharedBuffer&) {});
+        }
+        state.ResumeTiming();
+
+        manager.unloadAll();
+    }
+}
+BENCHMARK(BM_UnloadAll)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,73 @@
+# Collects the symbols imported by a set of Emscripten side modules so the
+# host can be linked with MAIN_MODULE=2 and export only what plugins use.
+#
+# Usage:
+#   cmake -DNM=<emnm> -DSIDE_MODULES=<a.wasm|b.wasm> -DALLOWLIST=<file>
+#         -DOUTPUT=<exports.txt> -P collect_side_module_imports.cmake
+
+cmake_minimum_required(VERSION 3.20)
+
+if(NOT NM OR NOT OUTPUT)
+    message(FATAL_ERROR "NM and OUTPUT must be set")
+endif()
+
+# provided by the dynamic linker itself, never by host exports
+set(DYLINK_BUILTINS
+    __memory_base
+    __table_base
+    __stack_pointer
+    __indirect_function_table
+    memory
+)
+
+set(exports "_main")
+
+string(REPLACE "|" ";" side_modules "${SIDE_MODULES}")
+foreach(module IN LISTS side_modules)
+    if(NOT EXISTS "${module}")
+        message(WARNING "Side module ${module} does not exist, skipping")
+        continue()
+    endif()
+
+    execute_process(
+        COMMAND ${NM} --undefined-only "${module}"
+        OUTPUT_VARIABLE nm_output
+        RESULT_VARIABLE nm_result
+    )
+    if(NOT nm_result EQUAL 0)
+        message(FATAL_ERROR "${NM} failed on ${module}")
+    endif()
+
+    string(REPLACE "\n" ";" nm_lines "${nm_output}")
+    foreach(line IN LISTS nm_lines)
+        if(line MATCHES "^[ \t]*[Uwv][ \t]+(.+)$")
+            set(symbol "${CMAKE_MATCH_1}")
+            if(NOT symbol IN_LIST DYLINK_BUILTINS)
+                list(APPEND exports "_${symbol}")
+            endif()
+        endif()
+    endforeach()
+endforeach()
+
+# symbols needed by plugins that are not built with this tree (remote plugins)
+if(ALLOWLIST AND EXISTS "${ALLOWLIST}")
+    file(STRINGS "${ALLOWLIST}" allowlist_lines)
+    foreach(line IN LISTS allowlist_lines)
+        string(STRIP "${line}" line)
+        if(line STREQUAL "" OR line MATCHES "^#")
+            continue()
+        endif()
+        list(APPEND exports "${line}")
+    endforeach()
+endif()
+
+list(REMOVE_DUPLICATES exports)
+list(SORT exports)
+list(LENGTH exports export_count)
+
+string(REPLACE ";" "\n" exports_text "${exports}")
+file(WRITE "${OUTPUT}.tmp" "${exports_text}\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
+
+message(STATUS "Host exports: ${export_count} symbol(s) written to ${OUTPUT}")
@@ -64,4 +64,68 @@ function(detect_and_add_plugins)
       message(WARNING "Plugin ${plugin} target not found")
     endif()
   endforeach()
+
+  # -DPLUGIN_SYNTHETIC_COUNT=N adds a fleet of generated plugins, see cmake/synthetic_plugins.cmake
+  add_synthetic_plugins(lib
+    COUNT ${PLUGIN_SYNTHETIC_COUNT}
+    SYMBOLS ${PLUGIN_SYNTHETIC_SYMBOLS}
+    SIZE_KB ${PLUGIN_SYNTHETIC_SIZE_KB}
+    INIT_US ${PLUGIN_SYNTHETIC_INIT_US}
+    OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/plugins/${SUBDIR}"
+  )
+endfunction()
+
+# Links the web host with MAIN_MODULE=2 and an explicit export list made of
+# every symbol imported by the side modules registered through add_plugin,
+# plus the allowlist in PLUGIN_HOST_EXPORT_ALLOWLIST for remote plugins.
+function(configure_host_exports host)
+  if(NOT EMSCRIPTEN)
+    return()
+  endif()
+
+  if(PLUGIN_HOST_MAIN_MODULE EQUAL 2)
+    get_property(side_modules GLOBAL PROPERTY PLUGIN_SIDE_MODULES)
+    set(module_files "")
+    foreach(plugin IN LISTS side_modules)
+      list(APPEND module_files "$<TARGET_FILE:${plugin}>")
+    endforeach()
+    string(JOIN "|" module_arg ${module_files})
+
+    set(exports_file "${CMAKE_BINARY_DIR}/${host}_exports.txt")
+    add_custom_command(
+      OUTPUT ${exports_file}
+      COMMAND ${CMAKE_COMMAND}
+        -DNM=${CMAKE_NM}
+        -DSIDE_MODULES=${module_arg}
+        -DALLOWLIST=${PLUGIN_HOST_EXPORT_ALLOWLIST}
+        -DOUTPUT=${exports_file}
+        -P ${PLUGIN_SYSTEM_BASE_FOLDER}/cmake/collect_side_module_imports.cmake
+      DEPENDS
+        ${side_modules}
+        ${PLUGIN_HOST_EXPORT_ALLOWLIST}
+        ${PLUGIN_SYSTEM_BASE_FOLDER}/cmake/collect_side_module_imports.cmake
+      COMMENT "Collecting side module imports for ${host}"
+      VERBATIM
+    )
+    add_custom_target(${host}_exports DEPENDS ${exports_file})
+    add_dependencies(${host} ${host}_exports)
+    set_property(TARGET ${host} APPEND PROPERTY LINK_DEPENDS ${exports_file})
+    set_property(TARGET ${host} APPEND_STRING PROPERTY LINK_FLAGS
+      " -s MAIN_MODULE=2 -sEXPORTED_FUNCTIONS=@${exports_file}")
+  else()
+    set_property(TARGET ${host} APPEND_STRING PROPERTY LINK_FLAGS
+      " -s EXPORT_ALL=1 -s MAIN_MODULE=1")
+  endif()
+
+  add_custom_command(
+    TARGET ${host}
+    POST_BUILD
+    COMMAND ${CMAKE_COMMAND}
+      -DNM=${CMAKE_NM}
+      -DWASM=$<TARGET_FILE_DIR:${host}>/${host}.wasm
+      -DMAIN_MODULE=${PLUGIN_HOST_MAIN_MODULE}
+      -DOUTPUT=${CMAKE_BINARY_DIR}/${host}_size_report.json
+      -P ${PLUGIN_SYSTEM_BASE_FOLDER}/cmake/wasm_size_report.cmake
+    VERBATIM
+  )
 endfunction()
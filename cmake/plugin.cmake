@@ -12,9 +12,105 @@ if (NOT TARGET lib_wrap)
     endif()
 endif()
 
+include(CheckLinkerFlag)
+
+# Artifact pipeline, see add_plugin_artifact_steps() below
+option(PLUGIN_OPTIMIZE_ARTIFACTS "Garbage-collect sections, fold identical code and strip plugins after linking" ON)
+if(EMSCRIPTEN)
+    # DWARF in a side module limits binaryen to the optimizations that keep it valid
+    set(PLUGIN_SPLIT_DEBUG_DEFAULT OFF)
+else()
+    set(PLUGIN_SPLIT_DEBUG_DEFAULT ON)
+endif()
+option(PLUGIN_SPLIT_DEBUG_INFO "Keep plugin debug info in ${CMAKE_BINARY_DIR}/plugin-debug instead of dropping it" ${PLUGIN_SPLIT_DEBUG_DEFAULT})
+set(PLUGIN_SIZE_BUDGET_KB 0 CACHE STRING "Fail the build when a plugin is larger than this many KiB (0 disables)")
+set(PLUGIN_LOAD_BUDGET_US 0 CACHE STRING "Fail the build when loading a plugin takes longer than this many microseconds (0 disables)")
+set(PLUGIN_REPORT_RUNS 5 CACHE STRING "Load time samples per plugin report; the median is reported")
+
+if(NOT EMSCRIPTEN AND NOT APPLE AND CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    # gold and lld only; the safe variant keeps functions whose address is taken apart
+    check_linker_flag(CXX "-Wl,--icf=safe" PLUGIN_LINKER_HAS_ICF)
+endif()
+
+# Optimizes a linked plugin in place and writes plugin_reports/<name>.json with
+# its size, exported symbols, relocations and measured load time.
+function(add_plugin_artifact_steps name)
+    cmake_parse_arguments(ARTIFACT "" "SIZE_BUDGET_KB;LOAD_BUDGET_US" "" ${ARGN})
+    set(debug_dir ${CMAKE_BINARY_DIR}/plugin-debug)
+    set(report_dir ${CMAKE_BINARY_DIR}/plugin_reports)
+    set(debug_file "")
+
+    if(PLUGIN_OPTIMIZE_ARTIFACTS AND EMSCRIPTEN)
+        # wasm-ld already drops unreferenced sections; the -O3 wasm-opt pass folds
+        # duplicate functions and drops the name section unless DWARF is kept
+        if(PLUGIN_SPLIT_DEBUG_INFO)
+            target_compile_options(${name} PRIVATE -g)
+            target_link_options(${name} PRIVATE -gseparate-dwarf=${debug_dir}/${name}.debug.wasm)
+            set(debug_file ${debug_dir}/${name}.debug.wasm)
+            add_custom_command(TARGET ${name} PRE_LINK COMMAND ${CMAKE_COMMAND} -E make_directory ${debug_dir} VERBATIM)
+        endif()
+    elseif(PLUGIN_OPTIMIZE_ARTIFACTS AND CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+        target_compile_options(${name} PRIVATE -ffunction-sections -fdata-sections)
+        if(APPLE)
+            target_link_options(${name} PRIVATE -Wl,-dead_strip)
+        else()
+            target_link_options(${name} PRIVATE -Wl,--gc-sections)
+            if(PLUGIN_LINKER_HAS_ICF)
+                target_link_options(${name} PRIVATE -Wl,--icf=safe)
+            endif()
+        endif()
+
+        if(APPLE)
+            find_program(DSYMUTIL dsymutil)
+            if(PLUGIN_SPLIT_DEBUG_INFO AND DSYMUTIL)
+                add_custom_command(TARGET ${name} POST_BUILD
+                    COMMAND ${DSYMUTIL} $<TARGET_FILE:${name}> -o ${debug_dir}/$<TARGET_FILE_NAME:${name}>.dSYM
+                    VERBATIM
+                )
+            endif()
+            add_custom_command(TARGET ${name} POST_BUILD COMMAND ${CMAKE_STRIP} -x $<TARGET_FILE:${name}> VERBATIM)
+        elseif(PLUGIN_SPLIT_DEBUG_INFO AND CMAKE_OBJCOPY)
+            # gdb finds the split file through the debuglink once debug-file-directory points at plugin-debug/
+            set(debug_file ${debug_dir}/$<TARGET_FILE_NAME:${name}>.debug)
+            add_custom_command(TARGET ${name} POST_BUILD
+                COMMAND ${CMAKE_COMMAND} -E make_directory ${debug_dir}
+                COMMAND ${CMAKE_OBJCOPY} --only-keep-debug $<TARGET_FILE:${name}> ${debug_file}
+                COMMAND ${CMAKE_OBJCOPY} --strip-unneeded --add-gnu-debuglink=${debug_file} $<TARGET_FILE:${name}>
+                VERBATIM
+            )
+        elseif(CMAKE_STRIP)
+            add_custom_command(TARGET ${name} POST_BUILD COMMAND ${CMAKE_STRIP} --strip-unneeded $<TARGET_FILE:${name}> VERBATIM)
+        endif()
+    endif()
+
+    # plugin_worker --probe dlopens a plugin against the same host symbols the real hosts export
+    set(probe "")
+    if(TARGET plugin_worker AND NOT EMSCRIPTEN)
+        add_dependencies(${name} plugin_worker)
+        set(probe $<TARGET_FILE:plugin_worker>)
+    endif()
+
+    add_custom_command(TARGET ${name} POST_BUILD
+        COMMAND ${CMAKE_COMMAND}
+            -DPLUGIN=$<TARGET_FILE:${name}>
+            -DNAME=${name}
+            -DNM=${CMAKE_NM}
+            -DREADELF=${CMAKE_READELF}
+            -DDEBUG_FILE=${debug_file}
+            -DWASM=$<BOOL:${EMSCRIPTEN}>
+            -DPROBE=${probe}
+            -DRUNS=${PLUGIN_REPORT_RUNS}
+            -DSIZE_BUDGET_KB=${ARTIFACT_SIZE_BUDGET_KB}
+            -DLOAD_BUDGET_US=${ARTIFACT_LOAD_BUDGET_US}
+            -DOUTPUT=${report_dir}/${name}.json
+            -P ${PLUGIN_SYSTEM_BASE_FOLDER}/cmake/plugin_report.cmake
+        VERBATIM
+    )
+endfunction()
+
 function(add_plugin parent ${ARGN})
     set(options LIBRARY_PLUGIN)
-    set(oneValueArgs NAME)
+    set(oneValueArgs NAME SIZE_BUDGET_KB LOAD_BUDGET_US)
     set(multiValueArgs SOURCES INCLUDES SYSTEM_INCLUDES LIBRARIES TESTS DEPENDS)
     cmake_parse_arguments(PLUGIN "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
 
@@ -60,7 +156,9 @@ function(add_plugin parent ${ARGN})
                PREFIX ""
                SUFFIX ${PLUGIN_SUFFIX}.wasm
   )
-        target_link_options(${PLUGIN_NAME} PRIVATE -sSIDE_MODULE=2 -O3 -sWASM=1 -sEXPORT_ALL=0 --no-entry -sERROR_ON_UNDEFINED_SYMBOLS=0 -Wno-limited-postlink-optimizations -flto -fno-rtti -fno-exceptions -sDISABLE_EXCEPTION_CATCHING=1)
+        # the host links with MAIN_MODULE=2 and only exports what side modules import
+        set_property(GLOBAL APPEND PROPERTY PLUGIN_SIDE_MODULES ${PLUGIN_NAME})
+        target_link_options(${PLUGIN_NAME} PRIVATE -sSIDE_MODULE=2 -O3 -sWASM=1 -sEXPORT_ALL=0 --no-entry -sERROR_ON_UNDEFINED_SYMBOLS=0 -flto -fno-rtti -fno-exceptions -sDISABLE_EXCEPTION_CATCHING=1)
     else()
         set_target_properties(
     ${PLUGIN_NAME}
@@ -105,6 +203,14 @@ function(add_plugin parent ${ARGN})
         set_target_properties(${PLUGIN_NAME} PROPERTIES LINK_FLAGS "-rdynamic")
     endif()
 
+    # per-plugin budgets fall back to the PLUGIN_*_BUDGET_* cache entries
+    if(NOT STATIC_LINK_PLUGINS)
+        add_plugin_artifact_steps(${PLUGIN_NAME}
+            SIZE_BUDGET_KB ${PLUGIN_SIZE_BUDGET_KB}
+            LOAD_BUDGET_US ${PLUGIN_LOAD_BUDGET_US}
+        )
+    endif()
+
 
 endfunction()
 
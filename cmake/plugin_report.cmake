@@ -0,0 +1,141 @@
+# Writes a JSON report about one built plugin: shipped and gzipped size, split
+# debug info, exported and imported symbols, relocations and the median time
+# plugin_worker --probe takes to load it. Fails when a budget is exceeded, so
+# bloat is caught when the plugin is built rather than in the field.
+#
+# Usage:
+#   cmake -DPLUGIN=<file> -DNAME=<name> -DOUTPUT=<report.json>
+#         [-DNM=<nm>] [-DREADELF=<readelf>] [-DWASM=<0|1>] [-DDEBUG_FILE=<file>]
+#         [-DPROBE=<plugin_worker>] [-DRUNS=<n>]
+#         [-DSIZE_BUDGET_KB=<k>] [-DLOAD_BUDGET_US=<us>] -P plugin_report.cmake
+
+cmake_minimum_required(VERSION 3.20)
+
+if(NOT PLUGIN OR NOT NAME OR NOT OUTPUT)
+    message(FATAL_ERROR "PLUGIN, NAME and OUTPUT must be set")
+endif()
+if(NOT RUNS OR RUNS LESS 1)
+    set(RUNS 1)
+endif()
+
+file(SIZE "${PLUGIN}" plugin_size)
+
+# the registry serves plugins as they are, but proxies and the web host may gzip them
+get_filename_component(output_dir "${OUTPUT}" DIRECTORY)
+file(MAKE_DIRECTORY "${output_dir}")
+set(gzip_file "${OUTPUT}.gz")
+file(ARCHIVE_CREATE
+    OUTPUT "${gzip_file}"
+    PATHS "${PLUGIN}"
+    FORMAT raw
+    COMPRESSION GZip
+)
+file(SIZE "${gzip_file}" gzip_size)
+file(REMOVE "${gzip_file}")
+
+function(count_lines out regex)
+    execute_process(
+        COMMAND ${ARGN}
+        OUTPUT_VARIABLE tool_output
+        RESULT_VARIABLE tool_result
+        ERROR_QUIET
+    )
+    set(count "null")
+    if(tool_result EQUAL 0)
+        string(REGEX MATCHALL "${regex}" matches "${tool_output}")
+        list(LENGTH matches count)
+    endif()
+    set(${out} ${count} PARENT_SCOPE)
+endfunction()
+
+# wasm side modules export through the module's export section, native ones through .dynsym
+set(exported_symbols "null")
+set(imported_symbols "null")
+if(NM)
+    if(WASM)
+        set(nm_scope --extern-only)
+    else()
+        set(nm_scope --dynamic)
+    endif()
+    count_lines(exported_symbols "[^\n]+" ${NM} ${nm_scope} --defined-only "${PLUGIN}")
+    count_lines(imported_symbols "[^\n]+" ${NM} ${nm_scope} --undefined-only "${PLUGIN}")
+endif()
+
+# relative relocations are cheap; symbolic ones each cost the loader a symbol lookup
+set(relocations "null")
+set(symbol_relocations "null")
+if(READELF AND NOT WASM)
+    count_lines(relocations "\n[0-9a-f]+ +[0-9a-f]+ R_" ${READELF} --relocs --wide "${PLUGIN}")
+    count_lines(relative_relocations "\n[0-9a-f]+ +[0-9a-f]+ R_[A-Z0-9_]+_RELATIVE" ${READELF} --relocs --wide "${PLUGIN}")
+    if(NOT relocations STREQUAL "null")
+        math(EXPR symbol_relocations "${relocations} - ${relative_relocations}")
+    endif()
+endif()
+
+set(debug_size "null")
+if(DEBUG_FILE AND EXISTS "${DEBUG_FILE}" AND NOT IS_DIRECTORY "${DEBUG_FILE}")
+    file(SIZE "${DEBUG_FILE}" debug_size)
+endif()
+
+# each sample is a fresh process, so the plugin is never already mapped
+set(load_us "null")
+if(PROBE AND NOT WASM)
+    set(samples "")
+    foreach(run RANGE 1 ${RUNS})
+        execute_process(
+            COMMAND ${PROBE} --probe "${PLUGIN}"
+            OUTPUT_VARIABLE probe_output
+            RESULT_VARIABLE probe_result
+            OUTPUT_STRIP_TRAILING_WHITESPACE
+        )
+        # the time is the last line; static initializers may print before it
+        string(REGEX MATCH "[0-9]+$" sample "${probe_output}")
+        if(NOT probe_result EQUAL 0 OR sample STREQUAL "")
+            message(WARNING "${NAME}: load probe failed (${probe_result})")
+            set(samples "")
+            break()
+        endif()
+        list(APPEND samples ${sample})
+    endforeach()
+    list(LENGTH samples sample_count)
+    if(sample_count GREATER 0)
+        list(SORT samples COMPARE NATURAL)
+        math(EXPR middle "${sample_count} / 2")
+        list(GET samples ${middle} load_us)
+    endif()
+endif()
+
+file(WRITE "${OUTPUT}" "{
+  \"plugin\": \"${NAME}\",
+  \"file\": \"${PLUGIN}\",
+  \"bytes\": ${plugin_size},
+  \"gzip_bytes\": ${gzip_size},
+  \"debug_bytes\": ${debug_size},
+  \"exported_symbols\": ${exported_symbols},
+  \"imported_symbols\": ${imported_symbols},
+  \"relocations\": ${relocations},
+  \"symbol_relocations\": ${symbol_relocations},
+  \"load_us\": ${load_us},
+  \"load_runs\": ${RUNS}
+}
+")
+
+message(STATUS "${NAME}: ${plugin_size} bytes (${gzip_size} gzipped), ${exported_symbols} exports, "
+    "${relocations} relocations (${symbol_relocations} symbolic), load ${load_us} us")
+
+set(over_budget "")
+if(SIZE_BUDGET_KB GREATER 0)
+    math(EXPR size_budget "${SIZE_BUDGET_KB} * 1024")
+    if(plugin_size GREATER size_budget)
+        list(APPEND over_budget "${plugin_size} bytes exceeds the ${SIZE_BUDGET_KB} KiB size budget")
+    endif()
+endif()
+if(LOAD_BUDGET_US GREATER 0 AND NOT load_us STREQUAL "null")
+    if(load_us GREATER LOAD_BUDGET_US)
+        list(APPEND over_budget "loading takes ${load_us} us, over the ${LOAD_BUDGET_US} us budget")
+    endif()
+endif()
+if(over_budget)
+    string(JOIN "; " over_budget_text ${over_budget})
+    message(FATAL_ERROR "${NAME}: ${over_budget_text} (see ${OUTPUT})")
+endif()
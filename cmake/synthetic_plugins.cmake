@@ -0,0 +1,84 @@
+# Synthetic plugins for load and startup benchmarks.
+#
+# write_synthetic_plugin_source(<path> SYMBOLS <n> SIZE_KB <k> INIT_US <us>)
+#   Writes a plugin source that exports <n> functions called through a table
+#   (n relocations for the loader), carries <k> KiB of read-only data and spins
+#   for <us> microseconds in pluginMain to stand in for initialisation work.
+#
+# add_synthetic_plugins(<parent> COUNT <n> [SYMBOLS <n>] [SIZE_KB <k>] [INIT_US <us>] [OUTPUT_DIRECTORY <dir>])
+#   Generates synthetic_plugin_<i> targets through add_plugin, so they are built,
+#   exported and named like real plugins.
+
+function(write_synthetic_plugin_source path)
+    cmake_parse_arguments(SYNTHETIC "" "SYMBOLS;SIZE_KB;INIT_US" "" ${ARGN})
+    if(NOT SYNTHETIC_SYMBOLS OR SYNTHETIC_SYMBOLS LESS 1)
+        set(SYNTHETIC_SYMBOLS 1)
+    endif()
+    if(NOT SYNTHETIC_SIZE_KB)
+        set(SYNTHETIC_SIZE_KB 0)
+    endif()
+    if(NOT SYNTHETIC_INIT_US)
+        set(SYNTHETIC_INIT_US 0)
+    endif()
+
+    set(source "// generated by cmake/synthetic_plugins.cmake\n#include \"lib/plugin_api.h\"\n\n#include <chrono>\n\n")
+    set(table "")
+    math(EXPR last "${SYNTHETIC_SYMBOLS} - 1")
+    foreach(i RANGE ${last})
+        string(APPEND source "extern \"C\" EMSCRIPTEN_KEEPALIVE int synthetic_fn_${i}(int x) { return x * ${i} + 1; }\n")
+        string(APPEND table "    synthetic_fn_${i},\n")
+    endforeach()
+    string(APPEND source "\nstatic int (*const table[])(int) = {\n${table}};\n")
+
+    # a non-zero initialiser keeps the blob in the file instead of .bss
+    math(EXPR blobSize "${SYNTHETIC_SIZE_KB} * 1024 + 1")
+    string(APPEND source "\nstatic const unsigned char blob[${blobSize}] = { 1 };\nstatic const unsigned char* volatile blobRef = blob;\n")
+
+    string(APPEND source "
+EMSCRIPTEN_KEEPALIVE int pluginMain()
+{
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(${SYNTHETIC_INIT_US});
+    while (std::chrono::steady_clock::now() < until) {
+    }
+
+    int acc = blobRef[0];
+    for (auto fn : table) {
+        acc += fn(1);
+    }
+    return acc & 0x7fffffff;
+}
+")
+
+    # only touch the source when it changes, so reconfiguring does not rebuild
+    file(WRITE ${path}.tmp "${source}")
+    configure_file(${path}.tmp ${path} COPYONLY)
+endfunction()
+
+function(add_synthetic_plugins parent)
+    cmake_parse_arguments(SYNTHETIC "" "COUNT;SYMBOLS;SIZE_KB;INIT_US;OUTPUT_DIRECTORY" "" ${ARGN})
+    if(NOT SYNTHETIC_COUNT OR SYNTHETIC_COUNT LESS 1)
+        return()
+    endif()
+
+    message(STATUS "Generating ${SYNTHETIC_COUNT} synthetic plugin(s): ${SYNTHETIC_SYMBOLS} symbol(s), ${SYNTHETIC_SIZE_KB} KiB, ${SYNTHETIC_INIT_US} us init")
+
+    set(sourceDir ${CMAKE_BINARY_DIR}/synthetic_plugins)
+    file(MAKE_DIRECTORY ${sourceDir})
+
+    math(EXPR last "${SYNTHETIC_COUNT} - 1")
+    foreach(i RANGE ${last})
+        set(name synthetic_plugin_${i})
+        write_synthetic_plugin_source(${sourceDir}/${name}.cpp
+            SYMBOLS ${SYNTHETIC_SYMBOLS}
+            SIZE_KB ${SYNTHETIC_SIZE_KB}
+            INIT_US ${SYNTHETIC_INIT_US}
+        )
+        add_plugin(${parent} NAME ${name} SOURCES ${sourceDir}/${name}.cpp)
+        if(SYNTHETIC_OUTPUT_DIRECTORY)
+            set_target_properties(${name} PROPERTIES
+                RUNTIME_OUTPUT_DIRECTORY ${SYNTHETIC_OUTPUT_DIRECTORY}
+                LIBRARY_OUTPUT_DIRECTORY ${SYNTHETIC_OUTPUT_DIRECTORY}
+            )
+        endif()
+    endforeach()
+endfunction()
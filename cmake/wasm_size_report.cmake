@@ -0,0 +1,50 @@
+# Writes a small JSON report about a linked wasm module so MAIN_MODULE=1 and
+# MAIN_MODULE=2 builds of the host can be compared.
+#
+# Usage:
+#   cmake -DNM=<emnm> -DWASM=<host.wasm> -DMAIN_MODULE=<1|2>
+#         -DOUTPUT=<report.json> -P wasm_size_report.cmake
+
+cmake_minimum_required(VERSION 3.20)
+
+if(NOT WASM OR NOT OUTPUT)
+    message(FATAL_ERROR "WASM and OUTPUT must be set")
+endif()
+
+file(SIZE "${WASM}" wasm_size)
+
+# the transfer size is what the browser downloads with gzip content encoding
+set(gzip_file "${OUTPUT}.wasm.gz")
+file(ARCHIVE_CREATE
+    OUTPUT "${gzip_file}"
+    PATHS "${WASM}"
+    FORMAT raw
+    COMPRESSION GZip
+)
+file(SIZE "${gzip_file}" gzip_size)
+file(REMOVE "${gzip_file}")
+
+set(export_count 0)
+if(NM)
+    execute_process(
+        COMMAND ${NM} --extern-only --defined-only "${WASM}"
+        OUTPUT_VARIABLE nm_output
+        RESULT_VARIABLE nm_result
+        ERROR_QUIET
+    )
+    if(nm_result EQUAL 0)
+        string(REGEX MATCHALL "[^\n]+" nm_lines "${nm_output}")
+        list(LENGTH nm_lines export_count)
+    endif()
+endif()
+
+file(WRITE "${OUTPUT}" "{
+  \"module\": \"${WASM}\",
+  \"main_module\": ${MAIN_MODULE},
+  \"bytes\": ${wasm_size},
+  \"gzip_bytes\": ${gzip_size},
+  \"exported_symbols\": ${export_count}
+}
+")
+
+message(STATUS "host.wasm (MAIN_MODULE=${MAIN_MODULE}): ${wasm_size} bytes, ${gzip_size} gzipped, ${export_count} exports")
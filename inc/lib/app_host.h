@@ -10,9 +10,17 @@ public:
     AppHost();
     int run();
     void ShowPluginManagerWindow();
+    void ShowLogWindow();
+    void UpdateFrame();
     void CreateDockableWindows();
     HelloImGui::DockingParams CreateDefaultLayout();
 
+    // Update phase shared with the headless host: background results, frame
+    // allocators, plugin ticks, events, workers and prepared draw jobs.
+    static void UpdatePlugins(double nowSeconds);
+    // Windows owned by plugins: renderables, scheduler draws and prepared draws.
+    static void ShowPluginWindows();
+
 private:
 
     bool m_loadedDownloadedPlugins = false;
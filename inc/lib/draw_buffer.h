@@ -0,0 +1,66 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// DrawBuffer records 2D primitives without touching ImGui state, so plugins can
+// build their visual output on worker threads. Positions are relative to the
+// top-left corner of the window content region the buffer is composited into.
+// replay() turns the recording into ImDrawList calls on the main thread.
+class DrawBuffer {
+public:
+    enum class Type : uint8_t {
+        Line,
+        Rect,
+        RectFilled,
+        Circle,
+        CircleFilled,
+        Polyline,
+        Text,
+    };
+
+    struct Command {
+        Type type;
+        ImU32 color;
+        float thickness;
+        ImVec2 a;
+        ImVec2 b;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    void clear();
+
+    void line(ImVec2 a, ImVec2 b, ImU32 color, float thickness = 1.0f);
+    void rect(ImVec2 min, ImVec2 max, ImU32 color, float thickness = 1.0f);
+    void rectFilled(ImVec2 min, ImVec2 max, ImU32 color);
+    void circle(ImVec2 center, float radius, ImU32 color, float thickness = 1.0f);
+    void circleFilled(ImVec2 center, float radius, ImU32 color);
+    void polyline(const ImVec2* points, size_t count, ImU32 color, float thickness = 1.0f);
+    void text(ImVec2 pos, ImU32 color, std::string_view text);
+
+    // Space the composited content reserves in the window's layout.
+    void setContentSize(ImVec2 size) { contentSize_ = size; }
+    ImVec2 contentSize() const { return contentSize_; }
+
+    void replay(ImDrawList* drawList, ImVec2 origin) const;
+
+    // Flat encoding used to ship buffers between processes. deserialize() rejects
+    // input whose commands reference points or text outside the buffer.
+    void serialize(std::vector<uint8_t> &out) const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+    const std::vector<Command>& commands() const { return commands_; }
+    const std::vector<ImVec2>& points() const { return points_; }
+    const std::string& text() const { return text_; }
+
+private:
+    std::vector<Command> commands_;
+    std::vector<ImVec2> points_;
+    std::string text_;
+    ImVec2 contentSize_ = ImVec2(0, 0);
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <lib/draw_buffer.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+// PrepareFunc fills `out` on a worker thread and must not call into ImGui.
+// `available` is the window's content size as of the last composited frame.
+// Return false to keep showing the previous output, e.g. when no data changed.
+using PrepareFunc = std::function<bool(DrawBuffer& out, ImVec2 available)>;
+
+// DrawListComposer lets plugins build their visual output in parallel. In the
+// update phase every idle entry gets a job on the TaskPool that records into its
+// back buffer; finished buffers are swapped in on the main thread, and the draw
+// phase only replays the front buffers into their windows. Output lags the
+// frame it was requested in by one frame, and a slow plugin never stalls the
+// frame: it keeps its previous output until its job completes.
+class DrawListComposer {
+public:
+    using Handle = uint64_t;
+
+    static DrawListComposer& getInstance();
+
+    Handle registerPrepared(const std::string &owner, const std::string &label, PrepareFunc func);
+    // Waits for prepare jobs that are running plugin code and keeps queued ones
+    // from starting, so the plugins can be unloaded right after it returns.
+    void clear();
+
+    void submitFrame();
+    void composeAll();
+
+    // Out-of-process plugins: the host shows frames prepared in a worker process,
+    // which runs its prepare functions synchronously and reports their output.
+    void submitRemote(const std::string &owner, const std::string &label, DrawBuffer &&buffer);
+    ImVec2 availableFor(const std::string &owner, const std::string &label) const;
+    void setAvailable(const std::string &label, ImVec2 available);
+    void prepareNow(const std::function<void(const std::string &label, const DrawBuffer &buffer)> &emit);
+
+private:
+    DrawListComposer() = default;
+    ~DrawListComposer() = default;
+
+    struct Entry {
+        Handle handle;
+        std::string owner;
+        std::string label;
+        // empty for remote entries
+        PrepareFunc func;
+        DrawBuffer front;
+        DrawBuffer back;
+        ImVec2 available = ImVec2(0, 0);
+        std::atomic<bool> busy{false};
+        // held while a job runs `func`; clear() resets func under it
+        std::mutex funcMutex;
+        double prepareMs = 0.0;
+    };
+
+    Handle nextHandle_ = 1;
+    std::vector<std::shared_ptr<Entry>> entries_;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <lib/ring_buffer.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// SharedBuffer is an immutable, reference-counted payload. Buffers are always
+// allocated by the host (allocate/copyOf live in the host library), so the memory
+// and its deleter stay valid after the publishing plugin is unloaded. Copying a
+// SharedBuffer only bumps the reference count.
+class SharedBuffer {
+public:
+    SharedBuffer() = default;
+
+    static SharedBuffer allocate(size_t size);
+    static SharedBuffer copyOf(const void* data, size_t size);
+
+    // Writable until the buffer is published or copied.
+    std::byte* mutableData() { return bytes_.get(); }
+
+    const std::byte* data() const { return bytes_.get(); }
+    size_t size() const { return size_; }
+    long useCount() const { return bytes_.use_count(); }
+    explicit operator bool() const { return static_cast<bool>(bytes_); }
+
+    template <typename T>
+    const T* as() const
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "event payloads must be trivially copyable");
+        return size_ >= sizeof(T) ? reinterpret_cast<const T*>(bytes_.get()) : nullptr;
+    }
+
+private:
+    std::shared_ptr<std::byte[]> bytes_;
+    size_t size_ = 0;
+};
+
+// EventBus is a publish/subscribe channel between plugins and the host.
+//
+// publish() is lock-free and may be called from any thread; events are queued in
+// a bounded ring and delivered on the main thread by dispatch(), once per frame,
+// grouped by topic. Subscribing and unsubscribing happen on the main thread.
+// Subscriptions are owned by a plugin name and removed before the plugin is
+// unloaded, so no callback into unloaded code can run.
+class EventBus {
+public:
+    using TopicId = uint32_t;
+    using Subscription = uint64_t;
+    using Callback = std::function<void(const SharedBuffer& payload)>;
+    using BatchCallback = std::function<void(std::span<const SharedBuffer> payloads)>;
+
+    static constexpr size_t kQueueCapacity = 4096;
+
+    static EventBus& getInstance();
+
+    TopicId topicId(std::string_view name);
+    std::string topicName(TopicId id) const;
+
+    bool publish(TopicId topic, SharedBuffer payload);
+
+    Subscription subscribe(const std::string &owner, TopicId topic, Callback callback);
+    Subscription subscribeBatch(const std::string &owner, TopicId topic, BatchCallback callback);
+    void unsubscribe(Subscription subscription);
+    void clear();
+
+    // Delivers everything queued so far; events published by subscribers during
+    // dispatch are delivered on the next call.
+    size_t dispatch();
+
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    EventBus() = default;
+    ~EventBus() = default;
+
+    struct Event {
+        TopicId topic;
+        SharedBuffer payload;
+    };
+
+    struct Subscriber {
+        Subscription id;
+        std::string owner;
+        TopicId topic;
+        Callback callback;
+        BatchCallback batchCallback;
+        bool active = true;
+    };
+
+    RingBuffer<Event, kQueueCapacity> queue_;
+    std::atomic<uint64_t> dropped_{0};
+
+    // transparent, so lookups by string_view do not allocate
+    struct TopicHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    mutable std::mutex topicsMutex_;
+    std::unordered_map<std::string, TopicId, TopicHash, std::equal_to<>> topicIds_;
+    std::vector<std::string> topicNames_;
+
+    Subscription nextSubscription_ = 1;
+    std::vector<std::shared_ptr<Subscriber>> subscribers_;
+    std::vector<std::shared_ptr<Subscriber>> dispatchSubscribers_;
+
+    std::vector<Event> batch_;
+    std::vector<SharedBuffer> payloads_;
+};
+
+// EventTopic gives a bus topic a payload type.
+//
+//   static EventTopic<Sample> samples("sensors/samples");
+//   samples.publish(Sample{...});                        // copies the value once
+//   samples.subscribe(PLUGIN_LOG_TAG, [](const Sample& s) { ... });
+//
+// Large payloads should be written straight into EventBus-allocated memory and
+// published as a SharedBuffer, which is never copied.
+template <typename T>
+class EventTopic {
+    static_assert(std::is_trivially_copyable_v<T>, "event payloads must be trivially copyable");
+
+public:
+    explicit EventTopic(std::string_view name)
+        : id_(EventBus::getInstance().topicId(name))
+    {
+    }
+
+    EventBus::TopicId id() const { return id_; }
+
+    bool publish(const T& value) const
+    {
+        return EventBus::getInstance().publish(id_, SharedBuffer::copyOf(&value, sizeof(T)));
+    }
+
+    bool publish(SharedBuffer payload) const
+    {
+        return EventBus::getInstance().publish(id_, std::move(payload));
+    }
+
+    EventBus::Subscription subscribe(const std::string &owner, std::function<void(const T&)> callback) const
+    {
+        return EventBus::getInstance().subscribe(owner, id_,
+            [callback = std::move(callback)](const SharedBuffer& payload) {
+                if (const T* value = payload.as<T>()) {
+                    callback(*value);
+                }
+            });
+    }
+
+private:
+    EventBus::TopicId id_;
+};
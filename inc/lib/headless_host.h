@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// HeadlessHost runs plugins without a window or GPU, e.g. on batch nodes and in
+// CI. Plugins are fetched, verified and initialized as usual and their ticks and
+// windows are driven for a fixed number of frames against an ImGui context that
+// has no renderer. The frame clock is simulated: frame n runs at n / fps seconds
+// no matter how long frames take, and the host reports how long each phase took.
+//
+// Plugins that talk to HelloImGui directly (e.g. AddDockableWindow) need a runner
+// and are not supported here; use the PluginManager draw APIs instead.
+class HeadlessHost {
+public:
+    struct Options {
+        uint64_t frames = 600;
+        double fps = 60.0;
+        // 0 runs background jobs inline, which makes prepared draws deterministic
+        unsigned workers = 4;
+        uint64_t timeoutMs = 5000;
+        bool offline = false;
+        bool installAll = false;
+        std::string reportPath;
+    };
+
+    // Returns 1 for headless mode, 0 when argv has no --headless (the other
+    // arguments are then left to the windowed host) and -1 after printing usage
+    // for an invalid option.
+    static int parseArgs(int argc, char** argv, Options &options);
+
+    explicit HeadlessHost(const Options &options);
+    int run();
+
+private:
+    void loadPlugins();
+    template <typename Done>
+    bool pumpUntil(Done done);
+
+    Options m_options;
+};
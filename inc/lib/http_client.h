@@ -0,0 +1,21 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <atomic>
+#include <string>
+
+class DigestStream;
+
+struct HttpOptions {
+    // hashes the body as it arrives
+    DigestStream* digest = nullptr;
+    // passed to CURLOPT_MAX_RECV_SPEED_LARGE, 0 is unlimited
+    curl_off_t maxBytesPerSecond = 0;
+    // aborts the transfer once set
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+// Blocking GET for worker threads (native only). HTTP errors fail the request
+// instead of returning the error page as the body.
+CURLcode httpGet(const std::string &url, std::string &response, const HttpOptions &options = {});
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <lib/plugin_api.h>
+#include <lib/ring_buffer.h>
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+enum class LogLevel : int {
+    Trace = PLUGIN_LOG_LEVEL_TRACE,
+    Debug = PLUGIN_LOG_LEVEL_DEBUG,
+    Info = PLUGIN_LOG_LEVEL_INFO,
+    Warn = PLUGIN_LOG_LEVEL_WARN,
+    Error = PLUGIN_LOG_LEVEL_ERROR,
+};
+
+const char* logLevelName(LogLevel level);
+
+// Fixed-size so records can live in the lock-free ring without allocating. Longer
+// tags and messages are cut and end in an ellipsis (U+2026).
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    uint64_t timestampMs = 0;
+    char tag[24] = {};
+    char message[216] = {};
+};
+
+// Logger queues records from any thread into a lock-free ring and hands them to
+// the sinks (stdout, an optional file and the in-app console history) from a
+// background thread. Producers never wait: when the ring is full the record is
+// dropped and counted. Builds without threads drain the ring once per frame.
+class Logger {
+public:
+    static constexpr size_t kHistorySize = 2000;
+
+    static Logger& getInstance();
+
+    void start(const std::string &filePath = "");
+    void stop();
+
+    void write(LogLevel level, std::string_view tag, std::string_view message);
+
+    // Drains queued records on the calling thread when there is no sink thread.
+    void pump();
+
+    // Hands drained records to `forwarder` instead of the sinks; plugin_worker uses
+    // this to ship its records to the host. Set before start().
+    void setForwarder(std::function<void(const LogRecord&)> forwarder);
+
+    template <typename Fn>
+    void forEachRecent(Fn&& fn) const
+    {
+        std::lock_guard<std::mutex> lock(historyMutex_);
+        for (const auto& record : history_) {
+            fn(record);
+        }
+    }
+
+    void clearHistory();
+    uint64_t droppedCount() const;
+
+private:
+    Logger() = default;
+    ~Logger();
+
+    void drain();
+    void sinkLoop();
+    void wakeSink();
+
+    RingBuffer<LogRecord, 2048> queue_;
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t reportedDropped_ = 0;
+
+    std::thread sinkThread_;
+    std::atomic<bool> running_{false};
+    // the sink thread sleeps on wakeups_ while sinkWaiting_ is set, so producers
+    // only pay for a wake (a futex) when the ring was empty
+    std::atomic<bool> sinkWaiting_{false};
+    std::atomic<uint32_t> wakeups_{0};
+    std::mutex drainMutex_;
+    std::ofstream file_;
+    std::function<void(const LogRecord&)> forwarder_;
+
+    mutable std::mutex historyMutex_;
+    std::deque<LogRecord> history_;
+};
+
+#define HOST_LOG(level, tag, message)                                     \
+    do {                                                                  \
+        if (static_cast<int>(level) >= PLUGIN_LOG_MIN_LEVEL) {            \
+            Logger::getInstance().write((level), (tag), (message));       \
+        }                                                                 \
+    } while (0)
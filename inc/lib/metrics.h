@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+enum class MetricType {
+    Counter,
+    Gauge,
+    Histogram,
+};
+
+// One time series: a metric name with a fixed set of labels. Updates are plain
+// atomics, so instrumented paths never wait on each other or on the exporter.
+class Metric {
+public:
+    Metric(MetricType type, const std::vector<double> &bounds);
+
+    MetricType type() const { return type_; }
+
+    // Counters ignore negative increments; gauges accept any value.
+    void add(double value);
+    void set(double value);
+    // Histograms only.
+    void observe(double value);
+
+    double value() const { return value_.load(std::memory_order_relaxed); }
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    const std::vector<double>& bounds() const { return bounds_; }
+    uint64_t bucketCount(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+
+private:
+    MetricType type_;
+    // counter/gauge value, or the sum of all observations for histograms
+    std::atomic<double> value_{0.0};
+    std::atomic<uint64_t> count_{0};
+    std::vector<double> bounds_;
+    // one per bound plus the implicit +Inf bucket, not cumulative
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+};
+
+// Metrics is the process-wide registry behind the host's own instrumentation and
+// the pluginMetric* functions of plugin_api.h. Series are created once and then
+// updated lock-free; only registration and export take the registry lock.
+//
+// Nothing is exported by default. PLUGIN_METRICS_FILE=<path> rewrites a Prometheus
+// text file every PLUGIN_METRICS_INTERVAL_MS (default 10000) for node_exporter's
+// textfile collector, and PLUGIN_METRICS_PORT=<port> serves the same text on
+// http://127.0.0.1:<port>/metrics (native hosts only).
+class Metrics {
+public:
+    static Metrics& getInstance();
+
+    // Return the existing series when the name and labels are already registered,
+    // or nullptr when the name is invalid or taken by a metric of another type.
+    // `labels` is in exposition form, e.g. label("plugin", "plugin_a").
+    Metric* counter(const std::string &name, const std::string &help, const std::string &labels = "");
+    Metric* gauge(const std::string &name, const std::string &help, const std::string &labels = "");
+    Metric* histogram(const std::string &name, const std::string &help, const std::vector<double> &bounds,
+                      const std::string &labels = "");
+
+    static std::string label(const std::string &key, const std::string &value);
+    // Default buckets for durations in seconds, 100us to 10s.
+    static const std::vector<double>& durationBuckets();
+
+    std::string renderPrometheus() const;
+
+    // Reads the environment; returns true when an exporter was started.
+    bool start();
+    void stop();
+    bool exporting() const { return !filePath_.empty() || port_ > 0; }
+
+    // Writes the file on the calling thread when there is no exporter thread.
+    void pump();
+
+private:
+    Metrics() = default;
+    ~Metrics();
+
+    struct Family {
+        MetricType type;
+        std::string help;
+        std::vector<double> bounds;
+        std::map<std::string, std::unique_ptr<Metric>> series;
+    };
+
+    Metric* series(const std::string &name, MetricType type, const std::string &help,
+                   const std::vector<double> &bounds, const std::string &labels);
+    bool writeFile();
+    void exportLoop();
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+
+    std::string filePath_;
+    std::chrono::milliseconds interval_{10000};
+    int port_ = 0;
+    std::chrono::steady_clock::time_point nextWrite_;
+
+    std::thread exportThread_;
+    std::atomic<bool> running_{false};
+};
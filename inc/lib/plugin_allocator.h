@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Per-plugin allocation counters, updated by every allocator the plugin owns.
+struct AllocationStats {
+    std::atomic<uint64_t> bytesInUse{0};
+    std::atomic<uint64_t> peakBytes{0};
+    std::atomic<uint64_t> bytesReserved{0};
+    std::atomic<uint64_t> liveAllocations{0};
+    std::atomic<uint64_t> totalAllocations{0};
+
+    void onAllocate(uint64_t bytes);
+    void onFree(uint64_t bytes, uint64_t count);
+};
+
+// Arena is a chunked bump allocator. Individual allocations are never freed;
+// reset() rewinds it (keeping its chunks for reuse) and release() returns all
+// memory at once. Allocation is thread-safe.
+class Arena {
+public:
+    explicit Arena(AllocationStats &stats, size_t chunkSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // `align` 0 means alignof(max_align_t); returns nullptr for other alignments
+    // that are not powers of two and when the chunk cannot be allocated.
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void reset();
+    void release();
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    AllocationStats &stats_;
+    size_t chunkSize_;
+    std::mutex mutex_;
+    std::vector<Chunk> chunks_;
+    size_t current_ = 0;
+    uint64_t bytesInUse_ = 0;
+    uint64_t allocations_ = 0;
+};
+
+// PoolAllocator hands out fixed-size blocks from chunks and recycles freed blocks
+// through a free list. Thread-safe.
+class PoolAllocator {
+public:
+    PoolAllocator(AllocationStats &stats, size_t blockSize, size_t blocksPerChunk = 64);
+    ~PoolAllocator();
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* allocate();
+    void deallocate(void* block);
+
+    size_t blockSize() const { return blockSize_; }
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    AllocationStats &stats_;
+    size_t blockSize_;
+    size_t blocksPerChunk_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<std::byte[]>> chunks_;
+    FreeNode* freeList_ = nullptr;
+    uint64_t liveBlocks_ = 0;
+};
+
+// AllocatorService gives every plugin its own arena, a frame arena for transient
+// UI data (rewound at the start of every frame, main thread only) and any number
+// of pools. Everything a plugin allocated through it is accounted to the plugin
+// and freed wholesale when the plugin is unloaded.
+class AllocatorService {
+public:
+    struct Usage {
+        std::string owner;
+        uint64_t bytesInUse;
+        uint64_t peakBytes;
+        uint64_t bytesReserved;
+        uint64_t liveAllocations;
+        uint64_t totalAllocations;
+    };
+
+    static AllocatorService& getInstance();
+
+    Arena& arena(const std::string &owner);
+    Arena& frameArena(const std::string &owner);
+    PoolAllocator& createPool(const std::string &owner, size_t blockSize, size_t blocksPerChunk = 64);
+
+    void beginFrame();
+
+    void releaseOwner(const std::string &owner);
+    void releaseAll();
+
+    std::vector<Usage> usage() const;
+
+private:
+    AllocatorService() = default;
+    ~AllocatorService() = default;
+
+    struct PluginHeap {
+        AllocationStats stats;
+        Arena arena{stats};
+        Arena frameArena{stats, 16 * 1024};
+        std::vector<std::unique_ptr<PoolAllocator>> pools;
+    };
+
+    PluginHeap& heap(const std::string &owner);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<PluginHeap>> heaps_;
+};
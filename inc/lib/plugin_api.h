@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <cstddef>
 
 #if defined(EMSCRIPTEN)
 #include "emscripten.h"
@@ -8,6 +9,17 @@
 #define EMSCRIPTEN_KEEPALIVE
 #endif
 
+#define PLUGIN_LOG_LEVEL_TRACE 0
+#define PLUGIN_LOG_LEVEL_DEBUG 1
+#define PLUGIN_LOG_LEVEL_INFO  2
+#define PLUGIN_LOG_LEVEL_WARN  3
+#define PLUGIN_LOG_LEVEL_ERROR 4
+
+// log statements below this level are compiled out
+#ifndef PLUGIN_LOG_MIN_LEVEL
+#define PLUGIN_LOG_MIN_LEVEL PLUGIN_LOG_LEVEL_DEBUG
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,11 +27,90 @@ extern "C" {
 
 int pluginMain();
 
+// Provided by the host. Queues a log record without blocking; safe from any thread.
+void pluginLog(int level, const char* tag, const char* message);
+
+// Provided by the host. Asks for a full-rate frame, e.g. after a tick changed data
+// a window displays; the host idles at a low frame rate otherwise. Thread-safe.
+void pluginRequestRedraw();
+
+// Provided by the host. Resolves a topic name to its event bus id once, e.g. in
+// pluginMain; ids stay valid for the lifetime of the host.
+unsigned pluginTopicId(const char* topic);
+// Provided by the host. Publishes a copy of `data` on the topic without taking a
+// lock; returns 0 when the queue is full. Safe from any thread.
+int pluginPublishTopic(unsigned topicId, const void* data, size_t size);
+// Convenience form that resolves the name on every call, under the topic lock.
+// See lib/event_bus.h for typed, zero-copy publishing.
+int pluginPublish(const char* topic, const void* data, size_t size);
+
+// Provided by the host. Allocations are accounted to `owner` (the plugin name) and
+// freed all at once when the plugin is unloaded; there is no per-allocation free.
+// Frame allocations are additionally rewound at the start of every frame and must
+// only be used from the main thread. `align` must be a power of two, 0 selects
+// alignof(max_align_t); NULL is returned otherwise or when memory runs out.
+// See lib/plugin_allocator.h for the C++ API.
+void* pluginArenaAlloc(const char* owner, size_t size, size_t align);
+void* pluginFrameAlloc(const char* owner, size_t size, size_t align);
+
+// Provided by the host. Fixed-size block pools owned by the plugin; blocks may be
+// returned individually and whatever remains is freed on unload. Thread-safe.
+void* pluginPoolCreate(const char* owner, size_t blockSize);
+void* pluginPoolAlloc(void* pool);
+void pluginPoolFree(void* pool, void* block);
+
+// Provided by the host. Metrics are exported with the host's own (see lib/metrics.h)
+// and labelled plugin="<owner>". Registering a name again returns the same metric;
+// NULL means the name is invalid or used by a metric of another type, and the
+// update functions ignore NULL. Updates are lock-free and safe from any thread.
+// Histograms without bounds use the host's duration buckets (seconds).
+void* pluginMetricCounter(const char* owner, const char* name, const char* help);
+void* pluginMetricGauge(const char* owner, const char* name, const char* help);
+void* pluginMetricHistogram(const char* owner, const char* name, const char* help, const double* bounds, size_t boundCount);
+void pluginMetricAdd(void* metric, double value);
+void pluginMetricSet(void* metric, double value);
+void pluginMetricObserve(void* metric, double value);
+
 
 #ifdef __cplusplus
 }
 #endif
 
+#define PLUGIN_STRINGIFY_IMPL(x) #x
+#define PLUGIN_STRINGIFY(x) PLUGIN_STRINGIFY_IMPL(x)
+
+#ifndef PLUGIN_OWNER
+#ifdef PLUGIN_NAME
+#define PLUGIN_OWNER PLUGIN_STRINGIFY(PLUGIN_NAME)
+#else
+#define PLUGIN_OWNER "plugin"
+#endif
+#endif
+
+#ifndef PLUGIN_LOG_TAG
+#define PLUGIN_LOG_TAG PLUGIN_OWNER
+#endif
+
+#define PLUGIN_ALLOC(size) pluginArenaAlloc(PLUGIN_OWNER, (size), alignof(std::max_align_t))
+#define PLUGIN_FRAME_ALLOC(size) pluginFrameAlloc(PLUGIN_OWNER, (size), alignof(std::max_align_t))
+
+#define PLUGIN_METRIC_COUNTER(name, help) pluginMetricCounter(PLUGIN_OWNER, (name), (help))
+#define PLUGIN_METRIC_GAUGE(name, help) pluginMetricGauge(PLUGIN_OWNER, (name), (help))
+#define PLUGIN_METRIC_HISTOGRAM(name, help) pluginMetricHistogram(PLUGIN_OWNER, (name), (help), nullptr, 0)
+
+#define PLUGIN_LOG(level, message)                                        \
+  do {                                                                    \
+    if ((level) >= PLUGIN_LOG_MIN_LEVEL) {                                \
+      pluginLog((level), PLUGIN_LOG_TAG, std::string(message).c_str());   \
+    }                                                                     \
+  } while (0)
+
+#define PLUGIN_LOG_TRACE(message) PLUGIN_LOG(PLUGIN_LOG_LEVEL_TRACE, message)
+#define PLUGIN_LOG_DEBUG(message) PLUGIN_LOG(PLUGIN_LOG_LEVEL_DEBUG, message)
+#define PLUGIN_LOG_INFO(message)  PLUGIN_LOG(PLUGIN_LOG_LEVEL_INFO, message)
+#define PLUGIN_LOG_WARN(message)  PLUGIN_LOG(PLUGIN_LOG_LEVEL_WARN, message)
+#define PLUGIN_LOG_ERROR(message) PLUGIN_LOG(PLUGIN_LOG_LEVEL_ERROR, message)
+
 inline std::string getPluginArchitecture() {
   #if defined(EMSCRIPTEN)
     return "emscripten";
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <lib/tiny_sha1.hpp>
+#include <lib/tiny_blake3.hpp>
+
+#include <string>
+#include <cstddef>
+
+// Catalog digests are tagged with their algorithm: "blake3:<hex>" or "sha1:<hex>".
+// Registries that predate the tag send a bare SHA1 hex string.
+enum class DigestAlgorithm {
+    Sha1,
+    Blake3,
+};
+
+struct PluginDigest {
+    DigestAlgorithm algorithm = DigestAlgorithm::Sha1;
+    std::string hex;
+
+    // Unknown algorithms parse to an empty digest.
+    static PluginDigest parse(const std::string &text);
+    // Empty for an empty digest.
+    std::string tagged() const;
+    bool empty() const { return hex.empty(); }
+};
+
+const char* digestAlgorithmName(DigestAlgorithm algorithm);
+
+// Hex digest of a buffer. Large BLAKE3 inputs are split along the hash tree and
+// the subtrees hashed on several threads; SHA1 is inherently sequential.
+std::string digestHex(DigestAlgorithm algorithm, const void* data, size_t size);
+
+// DigestStream hashes a download as it arrives, so verification overlaps the
+// transfer instead of following it.
+class DigestStream {
+public:
+    explicit DigestStream(DigestAlgorithm algorithm);
+
+    void update(const void* data, size_t size);
+    std::string finishHex() const;
+
+    DigestAlgorithm algorithm() const { return algorithm_; }
+
+private:
+    DigestAlgorithm algorithm_;
+    sha1::SHA1 sha1_;
+    blake3::Hasher blake3_;
+};
@@ -5,6 +5,11 @@
 #include <functional>
 #include <memory>
 #include <filesystem>
+#include <chrono>
+
+#include <lib/logger.h>
+#include <lib/scheduler.h>
+#include <lib/draw_list_composer.h>
 
 #ifdef EMSCRIPTEN
 #include "emscripten.h"
@@ -12,16 +17,22 @@
 #define EMSCRIPTEN_KEEPALIVE
 #endif
 
+// Hex SHA1 of a file's contents; throws std::runtime_error if it cannot be read.
+std::string sha1FileHex(const std::string &filePath);
+
 // RenderableFunc is a callback for rendering a plugin UI in ImGui
 using RenderableFunc = std::function<void()>;
 
 struct LoadablePlugin {
     std::string name;
     uint64_t size;
-    std::string sha1;
+    // algorithm-tagged catalog digest, e.g. "blake3:<hex>" (see lib/plugin_digest.h)
+    std::string digest;
     std::string version;
     std::filesystem::path downloadedPath = "";
     bool loaded = false;
+    // "in-process" (default) or "worker" to run it in a separate plugin_worker process
+    std::string execution = "in-process";
 };
 
 class PluginManager {
@@ -29,12 +40,27 @@ public:
     EMSCRIPTEN_KEEPALIVE static PluginManager& getInstance();
 
     void parsePluginList(const std::string &jsonData);
+    // Appends the entries of a catalog response to `plugins`; false if it is malformed.
+    static bool parseCatalog(const std::string &jsonData, std::vector<LoadablePlugin> &plugins);
+
+    // Catalog URL for this architecture (plugin binaries live below it) and the
+    // directory plugins are installed to, with a trailing separator.
+    static std::string catalogUrl();
+    static std::string installDir();
     int loadPlugin(LoadablePlugin &plugin);
 
+    // Checks a downloaded buffer against the catalog digest; safe to call from workers.
+    bool verifyPlugin(const LoadablePlugin &plugin, const char* data, size_t size);
+    // Same check for a digest computed while streaming the download.
+    bool verifyDigest(const LoadablePlugin &plugin, const std::string &hex);
+    // Persists an already verified buffer and loads it.
+    int installPlugin(LoadablePlugin &plugin, const std::string &localPath, const char* data, size_t size);
+
     void fetchPluginList();
     void downloadAndLoadPlugin(LoadablePlugin &plugin);
 
     std::vector<LoadablePlugin>& getPluginList();
+    LoadablePlugin* findPlugin(const std::string &name);
 
     const std::vector<RenderableFunc>& getRenderables() const;
 
@@ -42,10 +68,40 @@ public:
 
     EMSCRIPTEN_KEEPALIVE void registerRenderable(RenderableFunc func);
 
-    static void log(const std::string &msg);
+    // Scheduler API for plugins: periodic updates at their own rate, host-owned
+    // windows that are only redrawn at full rate when requestRedraw() is called.
+    EMSCRIPTEN_KEEPALIVE Scheduler::Handle registerTick(double rateHz, TickFunc func);
+    EMSCRIPTEN_KEEPALIVE Scheduler::Handle registerDraw(const std::string &label, DrawFunc func);
+    EMSCRIPTEN_KEEPALIVE void requestRedraw();
+
+    // Opt-in parallel drawing: `func` records the window's content on a worker
+    // thread and the host only composites the result.
+    EMSCRIPTEN_KEEPALIVE DrawListComposer::Handle registerPreparedDraw(const std::string &label, PrepareFunc func);
+
+    // Name of the plugin whose pluginMain is currently running, empty otherwise.
+    const std::string& currentPlugin() const;
+
+    static void log(const std::string &msg, LogLevel level = LogLevel::Info);
 
     void loadPreDownloadedPlugins();
 
+    // Asynchronous work still in flight (catalog fetch, downloads and, on the web,
+    // module compiles), so hosts can tell when startup has settled.
+    bool catalogPending() const { return catalogPending_; }
+    int pendingInstalls() const { return pendingInstalls_; }
+    void catalogFetchFailed();
+    void installFinished();
+
+#ifdef EMSCRIPTEN
+    // Completes a load started by loadPluginFromFile once the plugin's wasm
+    // module has been compiled (or fetched from the module cache) in the background.
+    void finishPluginLoad(const std::string &path, bool compiled);
+#endif
+
+    // Loads `path` into this process and runs its pluginMain regardless of its
+    // execution mode; plugin_worker uses this to host a plugin.
+    int openPlugin(const std::string &path);
+
 private:
     PluginManager() = default;
     ~PluginManager() = default;
@@ -54,6 +110,13 @@ private:
     std::vector<RenderableFunc> renderables_;
 
     std::vector<void*> pluginHandles_;
+    std::string currentPlugin_;
+
+    bool catalogPending_ = false;
+    int pendingInstalls_ = 0;
+    std::chrono::steady_clock::time_point catalogRequested_;
 
-    int loadPluginFromFile(const std::string &path);
+    int activatePlugin(LoadablePlugin &plugin);
+    int startPlugin(const std::string &path, const std::string &digest, const std::string &execution);
+    int loadPluginFromFile(const std::string &path, const std::string &digest = "");
 };
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+// PluginStore persists downloaded plugin files to PLUGIN_DEST.
+//
+// On Emscripten, writes land in MEMFS straight away and are flushed to IndexedDB
+// with a single FS.syncfs per batch: every download holds the batch open, and the
+// sync runs once the last one has been written. A flush requested while a sync is
+// already running is coalesced into one follow-up sync. On native platforms writes
+// go directly to disk and flushes complete immediately.
+class PluginStore {
+public:
+    using FlushCallback = std::function<void(bool ok)>;
+
+    static PluginStore& getInstance();
+
+    void beginBatch();
+    // `onComplete` runs once everything written in the batch has been persisted,
+    // with ok == false when the sync failed.
+    void endBatch(FlushCallback onComplete = nullptr);
+
+    bool write(const std::string &path, const void* data, size_t size);
+    void flush(FlushCallback onComplete = nullptr);
+
+#ifdef EMSCRIPTEN
+    void onSyncComplete(bool ok);
+#endif
+
+private:
+    PluginStore() = default;
+    ~PluginStore() = default;
+
+#ifdef EMSCRIPTEN
+    void startSync();
+#endif
+
+    int batchDepth_ = 0;
+    size_t dirtyFiles_ = 0;
+    bool syncInFlight_ = false;
+    bool syncQueued_ = false;
+    std::vector<FlushCallback> waiting_;
+    std::vector<FlushCallback> inFlight_;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <lib/plugin_digest.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdint>
+
+struct LoadablePlugin;
+
+// PluginUpdater keeps installed plugins current without costing the user any
+// latency. A background thread with low CPU and I/O priority polls the catalog
+// on a jittered schedule, so a fleet of hosts does not hit the registry at the
+// same instant. It downloads changed plugins under a bandwidth cap and stages
+// them, verified, in <install dir>/staged/. At the next start,
+// loadPreDownloadedPlugins() renames them over the installed files before
+// anything is loaded.
+//
+// PLUGIN_UPDATE_INTERVAL_S sets the poll period (default 1800, 0 disables), and
+// PLUGIN_UPDATE_MAX_KBPS the download cap in KiB/s (default 256, 0 is unlimited).
+// Only plugins that are already installed are updated. Native hosts only.
+class PluginUpdater {
+public:
+    static PluginUpdater& getInstance();
+
+    void start();
+    void stop();
+
+    // Polls at the next opportunity instead of waiting for the schedule.
+    void checkNow();
+
+    // Moves staged plugins over the installed ones; returns how many were applied.
+    int applyStaged();
+
+    // Drops a staged copy of `name`; called when a newer version is installed in
+    // the foreground, so applyStaged() cannot roll it back at the next start.
+    void discardStaged(const std::string &name);
+
+    // Plugins staged during this session, for the UI.
+    size_t stagedCount() const;
+
+private:
+    PluginUpdater() = default;
+    ~PluginUpdater();
+
+    void run();
+    void poll();
+    bool stage(const LoadablePlugin &plugin, const std::string &installedPath);
+    std::string installedDigest(const std::string &path, DigestAlgorithm algorithm);
+    std::chrono::steady_clock::duration nextDelay(bool first);
+
+    struct Installed {
+        uintmax_t size = 0;
+        int64_t mtime = 0;
+        std::string digest;
+    };
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> stopping_{false};
+    bool checkRequested_ = false;
+
+    std::chrono::seconds interval_{1800};
+    int64_t maxBytesPerSecond_ = 256 * 1024;
+    std::mt19937 rng_{std::random_device{}()};
+
+    // only touched by the updater thread
+    std::map<std::string, Installed> installed_;
+    // name -> tagged digest of the staged file, guarded by mutex_
+    std::map<std::string, std::string> staged_;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+class Metric;
+
+// TickFunc runs in the update phase, before the frame is built. It receives the
+// time elapsed since its previous run, in seconds.
+using TickFunc = std::function<void(double dt)>;
+// DrawFunc builds ImGui widgets for a window owned by the host.
+using DrawFunc = std::function<void()>;
+
+// Scheduler separates plugin updates from drawing. Ticks run at their own rate,
+// independent of the frame rate, and draws only need fresh frames when something
+// changed, which plugins signal with requestRedraw(). The host uses
+// secondsUntilNextTick() and consumeRedrawRequest() to idle between events.
+class Scheduler {
+public:
+    using Handle = uint64_t;
+
+    static Scheduler& getInstance();
+
+    Handle registerTick(const std::string &owner, double rateHz, TickFunc func);
+    Handle registerDraw(const std::string &owner, const std::string &label, DrawFunc func);
+
+    void remove(Handle handle);
+    void clear();
+
+    // Thread-safe; may be called from plugin workers.
+    void requestRedraw();
+    bool consumeRedrawRequest();
+
+    void runDueTicks(double nowSeconds);
+    void drawAll();
+
+    // Negative when no ticks are registered.
+    double secondsUntilNextTick(double nowSeconds) const;
+
+    size_t tickCount() const { return ticks_.size(); }
+
+    // Per-plugin time spent in ticks and draws, collected while profiling is on and
+    // also exported per frame as the plugin_frame_seconds histogram.
+    struct OwnerCost {
+        std::string owner;
+        uint64_t ticks = 0;
+        double tickMs = 0.0;
+        double drawMs = 0.0;
+    };
+
+    void setProfiling(bool enabled) { profiling_ = enabled; }
+    std::vector<OwnerCost> ownerCosts() const;
+
+private:
+    Scheduler() = default;
+    ~Scheduler() = default;
+
+    struct Tick {
+        Handle handle;
+        std::string owner;
+        double period;
+        double nextDue;
+        double lastRun;
+        TickFunc func;
+    };
+
+    struct Draw {
+        Handle handle;
+        std::string owner;
+        std::string label;
+        DrawFunc func;
+    };
+
+    Handle nextHandle_ = 1;
+    std::vector<Tick> ticks_;
+    std::vector<Draw> draws_;
+    std::atomic<bool> redrawRequested_{true};
+
+    bool profiling_ = false;
+    std::map<std::string, OwnerCost> costs_;
+    // time each owner spent in the current frame, flushed by drawAll()
+    std::map<std::string, double> frameMs_;
+    std::map<std::string, Metric*> frameMetrics_;
+};
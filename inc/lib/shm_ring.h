@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// ShmRing is a single-producer/single-consumer queue of framed messages stored in
+// memory the caller provides, typically a mapping shared between two processes.
+// Positions live in the mapping next to the data, so both sides only need the
+// base address. Writers never block: tryWrite fails when the message does not fit.
+class ShmRing {
+public:
+    // Positions are kept on separate cache lines ahead of the data.
+    static constexpr size_t kHeaderSize = 128;
+
+    // Every message is preceded by a frame header of this size.
+    static constexpr size_t kFrameSize = 8;
+
+    static constexpr size_t bytesFor(size_t capacity) { return kHeaderSize + capacity; }
+
+    // `capacity` must be a power of two and `memory` must hold bytesFor(capacity).
+    void attach(void* memory, size_t capacity);
+    // Resets the positions; only the side that created the mapping calls this.
+    void initialize();
+
+    bool tryWrite(uint32_t type, const void* data, size_t size);
+    // The positions and frame headers are written by the other process, so a
+    // reader cannot trust them: a frame that does not fit between tail and head
+    // marks the ring broken and every later read fails.
+    bool tryRead(uint32_t &type, std::vector<uint8_t> &payload);
+
+    bool empty() const;
+    bool broken() const { return broken_; }
+
+private:
+    struct Header {
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+    };
+    static_assert(sizeof(Header) <= kHeaderSize);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "positions must be address-free to be shared across processes");
+
+    struct Frame {
+        uint32_t type;
+        uint32_t size;
+    };
+    static_assert(sizeof(Frame) == kFrameSize);
+
+    void copyIn(uint64_t position, const void* data, size_t size);
+    void copyOut(uint64_t position, void* data, size_t size) const;
+
+    Header* header_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+    // local to the reading side, never in the shared mapping
+    bool broken_ = false;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+// StartupTimeline records where the time from main() to the first frame with all
+// plugins ready goes: catalog fetch, downloads, verification and plugin loads. It
+// is off unless PLUGIN_STARTUP_REPORT names a file, in which case the report is
+// written as JSON once the host reports a settled frame. PLUGIN_STARTUP_EXIT=1
+// asks the host to quit right after, for scripted benchmark runs.
+class StartupTimeline {
+public:
+    static StartupTimeline& getInstance();
+
+    bool enabled() const { return enabled_; }
+    double nowMs() const;
+
+    // Thread-safe.
+    void mark(const std::string &name);
+    void record(const std::string &name, double startMs, double endMs);
+
+    // Called by the host after every frame. Returns true when the host should exit.
+    bool frameRendered(const std::string &host, bool pluginsSettled);
+
+private:
+    StartupTimeline();
+    ~StartupTimeline() = default;
+
+    void writeReport(const std::string &host);
+
+    struct Span {
+        std::string name;
+        double startMs;
+        double endMs;
+    };
+
+    std::chrono::steady_clock::time_point origin_;
+    bool enabled_ = false;
+    bool exitWhenReady_ = false;
+    std::string reportPath_;
+
+    std::mutex mutex_;
+    std::vector<Span> spans_;
+    double firstFrameMs_ = -1.0;
+    double readyMs_ = -1.0;
+};
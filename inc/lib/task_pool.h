@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// TaskPool runs background work (downloads, hashing, file writes) on a small set of
+// worker threads and hands the results back to the render loop.
+//
+// A job runs on a worker and returns a continuation, which is queued for the main
+// thread and executed by drainMainThread() at the start of the next frame. Builds
+// without thread support (Emscripten without -pthread) run both inline.
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+    using Job = std::function<Task()>;
+
+    static TaskPool& getInstance();
+
+    void start(unsigned workerCount);
+    void stop();
+
+    void submit(Job job);
+    void post(Task task);
+
+    void drainMainThread();
+
+    bool isThreaded() const;
+
+private:
+    TaskPool() = default;
+    ~TaskPool();
+
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<Job> jobs_;
+    std::mutex jobsMutex_;
+    std::condition_variable jobsCv_;
+    bool stopping_ = false;
+
+    std::vector<Task> mainQueue_;
+    std::mutex mainMutex_;
+};
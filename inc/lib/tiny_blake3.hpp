@@ -0,0 +1,302 @@
+/*
+ *
+ * TinyBLAKE3 - a header only, portable implementation of the BLAKE3 hash
+ * (default hash mode, 32-byte output). Follows the structure of the BLAKE3
+ * reference implementation: https://github.com/BLAKE3-team/BLAKE3
+ *
+ * Besides the streaming Hasher, the tree is exposed (chunkOutput, parentOutput,
+ * leftSubtreeLen) so callers can hash independent subtrees on separate cores and
+ * merge their chaining values.
+ *
+ * Released into the public domain (CC0), like the reference implementation.
+ */
+#ifndef _TINY_BLAKE3_HPP_
+#define _TINY_BLAKE3_HPP_
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+namespace blake3
+{
+	static constexpr size_t OUT_LEN = 32;
+	static constexpr size_t BLOCK_LEN = 64;
+	static constexpr size_t CHUNK_LEN = 1024;
+
+	enum Flags : uint32_t {
+		CHUNK_START = 1 << 0,
+		CHUNK_END = 1 << 1,
+		PARENT = 1 << 2,
+		ROOT = 1 << 3,
+	};
+
+	static constexpr uint32_t IV[8] = {
+		0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+		0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+	};
+
+	static constexpr uint8_t MSG_PERMUTATION[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+	inline uint32_t rotr(uint32_t value, int count) {
+		return (value >> count) | (value << (32 - count));
+	}
+
+	inline uint32_t load32(const uint8_t* p) {
+		return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	}
+
+	inline void store32(uint8_t* p, uint32_t value) {
+		p[0] = uint8_t(value);
+		p[1] = uint8_t(value >> 8);
+		p[2] = uint8_t(value >> 16);
+		p[3] = uint8_t(value >> 24);
+	}
+
+	inline void g(uint32_t* s, int a, int b, int c, int d, uint32_t mx, uint32_t my) {
+		s[a] = s[a] + s[b] + mx;
+		s[d] = rotr(s[d] ^ s[a], 16);
+		s[c] = s[c] + s[d];
+		s[b] = rotr(s[b] ^ s[c], 12);
+		s[a] = s[a] + s[b] + my;
+		s[d] = rotr(s[d] ^ s[a], 8);
+		s[c] = s[c] + s[d];
+		s[b] = rotr(s[b] ^ s[c], 7);
+	}
+
+	inline void round(uint32_t* s, const uint32_t* m) {
+		g(s, 0, 4, 8, 12, m[0], m[1]);
+		g(s, 1, 5, 9, 13, m[2], m[3]);
+		g(s, 2, 6, 10, 14, m[4], m[5]);
+		g(s, 3, 7, 11, 15, m[6], m[7]);
+		g(s, 0, 5, 10, 15, m[8], m[9]);
+		g(s, 1, 6, 11, 12, m[10], m[11]);
+		g(s, 2, 7, 8, 13, m[12], m[13]);
+		g(s, 3, 4, 9, 14, m[14], m[15]);
+	}
+
+	// Full 16-word compression output; the first 8 words are the chaining value.
+	inline void compress(const uint32_t cv[8], const uint8_t block[BLOCK_LEN], uint8_t blockLen,
+	                     uint64_t counter, uint32_t flags, uint32_t out[16]) {
+		uint32_t m[16];
+		for (int i = 0; i < 16; i++) {
+			m[i] = load32(block + 4 * i);
+		}
+		uint32_t s[16] = {
+			cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+			IV[0], IV[1], IV[2], IV[3],
+			uint32_t(counter), uint32_t(counter >> 32), blockLen, flags,
+		};
+		for (int r = 0; r < 7; r++) {
+			round(s, m);
+			if (r < 6) {
+				uint32_t permuted[16];
+				for (int i = 0; i < 16; i++) {
+					permuted[i] = m[MSG_PERMUTATION[i]];
+				}
+				memcpy(m, permuted, sizeof(m));
+			}
+		}
+		for (int i = 0; i < 8; i++) {
+			out[i] = s[i] ^ s[i + 8];
+			out[i + 8] = s[i + 8] ^ cv[i];
+		}
+	}
+
+	// The last compression of a chunk or parent node, kept unevaluated until it is
+	// known whether the node is the root.
+	struct Output {
+		uint32_t inputCv[8];
+		uint8_t block[BLOCK_LEN];
+		uint8_t blockLen;
+		uint64_t counter;
+		uint32_t flags;
+
+		void chainingValue(uint32_t cv[8]) const {
+			uint32_t out[16];
+			compress(inputCv, block, blockLen, counter, flags, out);
+			memcpy(cv, out, 8 * sizeof(uint32_t));
+		}
+
+		void rootBytes(uint8_t digest[OUT_LEN]) const {
+			uint32_t out[16];
+			compress(inputCv, block, blockLen, 0, flags | ROOT, out);
+			for (int i = 0; i < 8; i++) {
+				store32(digest + 4 * i, out[i]);
+			}
+		}
+	};
+
+	class ChunkState {
+	public:
+		ChunkState() { reset(IV, 0); }
+
+		void reset(const uint32_t key[8], uint64_t chunkCounter) {
+			memcpy(m_cv, key, sizeof(m_cv));
+			m_chunkCounter = chunkCounter;
+			memset(m_block, 0, sizeof(m_block));
+			m_blockLen = 0;
+			m_blocksCompressed = 0;
+		}
+
+		size_t length() const { return BLOCK_LEN * m_blocksCompressed + m_blockLen; }
+		uint64_t chunkCounter() const { return m_chunkCounter; }
+
+		void update(const uint8_t* input, size_t len) {
+			while (len > 0) {
+				// only compress a full block once more input follows, the last one goes to output()
+				if (m_blockLen == BLOCK_LEN) {
+					uint32_t out[16];
+					compress(m_cv, m_block, BLOCK_LEN, m_chunkCounter, m_flags(), out);
+					memcpy(m_cv, out, sizeof(m_cv));
+					m_blocksCompressed++;
+					memset(m_block, 0, sizeof(m_block));
+					m_blockLen = 0;
+				}
+				size_t take = BLOCK_LEN - m_blockLen;
+				if (take > len) {
+					take = len;
+				}
+				memcpy(m_block + m_blockLen, input, take);
+				m_blockLen += uint8_t(take);
+				input += take;
+				len -= take;
+			}
+		}
+
+		Output output() const {
+			Output out;
+			memcpy(out.inputCv, m_cv, sizeof(m_cv));
+			memcpy(out.block, m_block, sizeof(m_block));
+			out.blockLen = m_blockLen;
+			out.counter = m_chunkCounter;
+			out.flags = m_flags() | CHUNK_END;
+			return out;
+		}
+
+	private:
+		uint32_t m_flags() const { return m_blocksCompressed == 0 ? uint32_t(CHUNK_START) : 0u; }
+
+		uint32_t m_cv[8];
+		uint64_t m_chunkCounter;
+		uint8_t m_block[BLOCK_LEN];
+		uint8_t m_blockLen;
+		uint8_t m_blocksCompressed;
+	};
+
+	// Output of a single chunk (at most CHUNK_LEN bytes) at position `chunkCounter`.
+	inline Output chunkOutput(const uint8_t* input, size_t len, uint64_t chunkCounter) {
+		ChunkState state;
+		state.reset(IV, chunkCounter);
+		state.update(input, len);
+		return state.output();
+	}
+
+	inline Output parentOutput(const uint32_t left[8], const uint32_t right[8]) {
+		Output out;
+		memcpy(out.inputCv, IV, sizeof(IV));
+		for (int i = 0; i < 16; i++) {
+			// the block is read as little-endian words
+			uint32_t word = i < 8 ? left[i] : right[i - 8];
+			store32(out.block + 4 * i, word);
+		}
+		out.blockLen = BLOCK_LEN;
+		out.counter = 0;
+		out.flags = PARENT;
+		return out;
+	}
+
+	// Size of the left subtree of an input longer than one chunk: the largest power
+	// of two number of chunks that leaves at least one byte for the right subtree.
+	inline size_t leftSubtreeLen(size_t len) {
+		size_t chunks = (len - 1) / CHUNK_LEN;
+		size_t pow2 = 1;
+		while (pow2 * 2 <= chunks) {
+			pow2 *= 2;
+		}
+		return pow2 * CHUNK_LEN;
+	}
+
+	inline Output subtreeOutput(const uint8_t* input, size_t len, uint64_t chunkCounter);
+
+	// Chaining value of the subtree over `input`, whose first chunk is `chunkCounter`.
+	inline void subtreeChainingValue(const uint8_t* input, size_t len, uint64_t chunkCounter, uint32_t cv[8]) {
+		subtreeOutput(input, len, chunkCounter).chainingValue(cv);
+	}
+
+	inline Output subtreeOutput(const uint8_t* input, size_t len, uint64_t chunkCounter) {
+		if (len <= CHUNK_LEN) {
+			return chunkOutput(input, len, chunkCounter);
+		}
+		size_t leftLen = leftSubtreeLen(len);
+		uint32_t left[8], right[8];
+		subtreeChainingValue(input, leftLen, chunkCounter, left);
+		subtreeChainingValue(input + leftLen, len - leftLen, chunkCounter + leftLen / CHUNK_LEN, right);
+		return parentOutput(left, right);
+	}
+
+	// Incremental hasher for input that arrives in pieces, e.g. while downloading.
+	class Hasher {
+	public:
+		typedef uint8_t digest8_t[OUT_LEN];
+
+		Hasher() { reset(); }
+
+		Hasher& reset() {
+			m_chunk.reset(IV, 0);
+			m_stackLen = 0;
+			return *this;
+		}
+
+		Hasher& processBytes(const void* const data, size_t len) {
+			const uint8_t* input = static_cast<const uint8_t*>(data);
+			while (len > 0) {
+				// a full chunk is only finished once more input follows it
+				if (m_chunk.length() == CHUNK_LEN) {
+					uint32_t cv[8];
+					m_chunk.output().chainingValue(cv);
+					uint64_t totalChunks = m_chunk.chunkCounter() + 1;
+					addChunkCv(cv, totalChunks);
+					m_chunk.reset(IV, totalChunks);
+				}
+				size_t take = CHUNK_LEN - m_chunk.length();
+				if (take > len) {
+					take = len;
+				}
+				m_chunk.update(input, take);
+				input += take;
+				len -= take;
+			}
+			return *this;
+		}
+
+		const uint8_t* getDigestBytes(digest8_t digest) const {
+			Output out = m_chunk.output();
+			for (size_t i = m_stackLen; i > 0; i--) {
+				uint32_t cv[8];
+				out.chainingValue(cv);
+				out = parentOutput(m_cvStack[i - 1], cv);
+			}
+			out.rootBytes(digest);
+			return digest;
+		}
+
+	private:
+		// merges completed subtrees: one pending CV per zero bit of the chunk count
+		void addChunkCv(uint32_t cv[8], uint64_t totalChunks) {
+			while ((totalChunks & 1) == 0) {
+				Output parent = parentOutput(m_cvStack[--m_stackLen], cv);
+				parent.chainingValue(cv);
+				totalChunks >>= 1;
+			}
+			memcpy(m_cvStack[m_stackLen++], cv, 8 * sizeof(uint32_t));
+		}
+
+		ChunkState m_chunk;
+		uint32_t m_cvStack[54][8];
+		size_t m_stackLen;
+	};
+
+	// One-shot hash of `len` bytes at `data`.
+	inline void hash(const void* data, size_t len, uint8_t digest[OUT_LEN]) {
+		subtreeOutput(static_cast<const uint8_t*>(data), len, 0).rootBytes(digest);
+	}
+}
+#endif
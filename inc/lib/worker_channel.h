@@ -0,0 +1,76 @@
+#pragma once
+
+#include <lib/shm_ring.h>
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Out-of-process plugins need memfd and eventfd, so they are Linux only.
+#if defined(__linux__) && !defined(EMSCRIPTEN)
+#define PLUGIN_WORKERS_SUPPORTED 1
+#else
+#define PLUGIN_WORKERS_SUPPORTED 0
+#endif
+
+enum class WorkerMessage : uint32_t {
+    // host -> worker
+    Shutdown = 1,
+    Viewport,       // u32 label length, label, float width, float height
+    // worker -> host
+    Ready,          // i32 pluginMain result
+    Log,            // LogRecord
+    RequestRedraw,
+    DrawFrame,      // u32 label length, label, serialized DrawBuffer
+};
+
+// WorkerChannel connects the host and one worker process through two ShmRings in
+// a single memfd mapping, one per direction. Each side has an eventfd the other
+// side signals after writing, so a waiting process can poll() instead of spin.
+// The host creates the channel and passes the three descriptors to the worker.
+class WorkerChannel {
+public:
+    static constexpr size_t kRingCapacity = 1 << 20;
+    // Larger messages never fit in the ring, however long the sender waits.
+    static constexpr size_t kMaxPayload = kRingCapacity - ShmRing::kFrameSize;
+
+    WorkerChannel() = default;
+    ~WorkerChannel();
+
+    WorkerChannel(const WorkerChannel&) = delete;
+    WorkerChannel& operator=(const WorkerChannel&) = delete;
+
+    bool create();
+    bool attach(int memFd, int hostEventFd, int workerEventFd);
+    void close();
+
+    bool send(WorkerMessage type, const void* data = nullptr, size_t size = 0);
+    bool receive(WorkerMessage &type, std::vector<uint8_t> &payload);
+    // The other side corrupted the inbound ring; nothing more can be received.
+    bool broken() const;
+
+    // Descriptor that becomes readable when messages arrive for this side.
+    int inboxEventFd() const { return isHost_ ? hostEventFd_ : workerEventFd_; }
+    void clearSignal();
+
+    int memFd() const { return memFd_; }
+    int hostEventFd() const { return hostEventFd_; }
+    int workerEventFd() const { return workerEventFd_; }
+
+private:
+    bool map();
+
+    int memFd_ = -1;
+    int hostEventFd_ = -1;
+    int workerEventFd_ = -1;
+    void* mapping_ = nullptr;
+    bool isHost_ = false;
+
+    ShmRing toWorker_;
+    ShmRing toHost_;
+};
+
+// Length-prefixed string helpers for message payloads.
+void appendWireString(std::vector<uint8_t> &out, const std::string &value);
+bool readWireString(const uint8_t* &data, const uint8_t* end, std::string &value);
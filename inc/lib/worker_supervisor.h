@@ -0,0 +1,54 @@
+#pragma once
+
+#include <lib/worker_channel.h>
+
+#include <imgui.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+// WorkerSupervisor runs plugins declared with `"execution": "worker"` in their own
+// plugin_worker process. A crashing or compute-heavy worker cannot take the UI
+// down with it: the host keeps drawing the worker's last frames and restarts it
+// with exponential backoff. Workers only get the process-portable plugin API
+// (ticks, prepared draws, logging, redraw requests and allocators); immediate
+// ImGui windows stay in-process only.
+class WorkerSupervisor {
+public:
+    static WorkerSupervisor& getInstance();
+
+    bool isSupported() const { return PLUGIN_WORKERS_SUPPORTED; }
+
+    // Starts a worker for the plugin at `path`; returns -1 when it cannot be spawned.
+    int spawn(const std::string &owner, const std::string &path);
+
+    // Called once per frame: applies worker messages and restarts dead workers.
+    void update();
+    void stopAll();
+
+private:
+    WorkerSupervisor() = default;
+    ~WorkerSupervisor();
+
+    struct Worker {
+        std::string owner;
+        std::string path;
+        int pid = -1;
+        std::unique_ptr<WorkerChannel> channel;
+        unsigned restarts = 0;
+        double startedAt = 0.0;
+        double restartAt = -1.0;
+        std::map<std::string, ImVec2> viewports;
+    };
+
+    bool launch(Worker &worker);
+    void handleMessage(Worker &worker, WorkerMessage type, const std::vector<uint8_t> &payload);
+    void syncViewports(Worker &worker);
+    // Collects an exited worker and schedules its restart; `block` waits for the exit.
+    void reap(Worker &worker, bool block = false);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<uint8_t> scratch_;
+};
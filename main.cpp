@@ -1,6 +1,28 @@
 #include "lib/app_host.h"
+#include "lib/startup_timeline.h"
+
+#ifndef EMSCRIPTEN
+#include "lib/headless_host.h"
+#endif
+
+int main(int argc, char** argv) {
+    StartupTimeline::getInstance().mark("main");
+
+#ifndef EMSCRIPTEN
+    HeadlessHost::Options options;
+    int headlessMode = HeadlessHost::parseArgs(argc, argv, options);
+    if (headlessMode < 0) {
+        return 2;
+    }
+    if (headlessMode > 0) {
+        HeadlessHost headless(options);
+        return headless.run();
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
 
-int main() {
     AppHost host;
 
     return host.run();
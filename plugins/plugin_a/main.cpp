@@ -3,29 +3,74 @@
 #include "lib/plugin_manager.h"
 #include <stdio.h>
 
-#include <memory>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
 
 #include <imgui.h>
-#include <hello_imgui/hello_imgui.h>
 
-  static std::shared_ptr<HelloImGui::DockableWindow> window;
+  static bool registered = false;
+  // written by the tick on the main thread, read by the plot worker
+  static std::atomic<double> uptime{0.0};
 
 EMSCRIPTEN_KEEPALIVE int pluginMain() {
-  printf("[Plugin A] Hello from Plugin A!\n");
+  PLUGIN_LOG_INFO("Hello from Plugin A!");
 
 
-  if (!window) {
-    window = std::make_shared<HelloImGui::DockableWindow>();
-    window->label = "Plugin A";
-    window->dockSpaceName = "MainDockSpace";
-    window->GuiFunction = [] {
+  if (!registered) {
+    registered = true;
+
+    // a host-owned window rather than a HelloImGui dockable, so the plugin also
+    // runs in the headless host
+    PluginManager::getInstance().registerDraw("Plugin A", [] {
       ImGui::Text("Plugin A GUI");
       ImGui::Text("This is a simple plugin that does nothing.");
       ImGui::Text("You can add your own functionality here.");
-    };
-    window->isVisible = true;
+      ImGui::Text("Loaded for %.0f s", uptime.load());
+    });
+
+    // exported with the host's metrics as plugin_a_ticks_total{plugin="plugin_a"}
+    static void* ticks = PLUGIN_METRIC_COUNTER("plugin_a_ticks_total", "Uptime ticks run by plugin A");
+
+    // the uptime only changes once a second, so the host can idle in between
+    PluginManager::getInstance().registerTick(1.0, [](double dt) {
+      uptime.store(uptime.load() + dt);
+      pluginMetricAdd(ticks, 1);
+      pluginRequestRedraw();
+    });
+
+    // plot scratch lives in the plugin's arena, so it shows up in the memory table
+    // and goes away with the plugin
+    constexpr int samples = 257;
+    auto* points = static_cast<ImVec2*>(PLUGIN_ALLOC(sizeof(ImVec2) * samples));
+    if (!points) {
+      PLUGIN_LOG_ERROR("Out of arena memory, the plot is disabled");
+      return 42;
+    }
+
+    // the plot is recorded on a worker thread; the host only composites it
+    PluginManager::getInstance().registerPreparedDraw("Plugin A Plot", [points](DrawBuffer& out, ImVec2 available) {
+      static double lastUptime = -1.0;
+      static float lastWidth = -1.0f;
+      double now = uptime.load();
+      float width = std::max(available.x, 100.0f);
+      if (now == lastUptime && width == lastWidth) {
+        return false;
+      }
+      lastUptime = now;
+      lastWidth = width;
 
-    HelloImGui::AddDockableWindow(window);
+      float height = 120.0f;
+      for (int i = 0; i < samples; i++) {
+        float t = i / (float)(samples - 1);
+        points[i] = ImVec2(t * width, height * 0.5f * (1.0f - std::sin(t * 12.0f + (float)now)));
+      }
+      out.rect(ImVec2(0, 0), ImVec2(width, height), IM_COL32(90, 90, 90, 255));
+      out.polyline(points, samples, IM_COL32(80, 200, 120, 255), 2.0f);
+      out.text(ImVec2(4, 4), IM_COL32(255, 255, 255, 255), "prepared off the main thread");
+      out.setContentSize(ImVec2(width, height));
+      return true;
+    });
   }
 
   return 42;
@@ -9,6 +9,6 @@
 #endif
 
 EMSCRIPTEN_KEEPALIVE int pluginMain() {
-  printf("[Plugin B] Hello from Plugin B!\n");
+  PLUGIN_LOG_INFO("Hello from Plugin B!");
   return 77;
 }
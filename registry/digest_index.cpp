@@ -0,0 +1,490 @@
+#include "digest_index.h"
+
+#include "lib/tiny_sha1.hpp"
+#include "lib/tiny_blake3.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <format>
+#include <tuple>
+#include <vector>
+
+static constexpr uint32_t ROOT_EVENTS = IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR;
+// files are picked up once fully written (or renamed into place), never half-copied
+static constexpr uint32_t ARCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB | IN_DELETE_SELF | IN_ONLYDIR;
+
+static bool IsPluginName(const std::string &name)
+{
+    auto endsWith = [&name](const char* suffix) {
+        size_t len = std::strlen(suffix);
+        return name.size() > len && name.compare(name.size() - len, len, suffix) == 0;
+    };
+    return endsWith(".plugin") || endsWith(".plugin.wasm");
+}
+
+static bool IsDirectory(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static std::string ToHex(const unsigned char* bytes, size_t size)
+{
+    std::string hex;
+    for (size_t i = 0; i < size; i++) {
+        hex += std::format("{:02x}", bytes[i]);
+    }
+    return hex;
+}
+
+static int64_t MtimeNs(const struct stat &st)
+{
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// hashes straight from the page cache, without copying the file into a buffer;
+// SHA1 stays in the catalog for clients that predate tagged digests. `st` is the
+// version that was hashed.
+static bool HashFile(const std::string &path, struct stat &st, std::string &sha1Hex, std::string &blake3Hex)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    sha1::SHA1 sha;
+    blake3::Hasher blake;
+    if (st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        sha.processBytes(data, st.st_size);
+        blake.processBytes(data, st.st_size);
+        munmap(data, st.st_size);
+    }
+    close(fd);
+
+    unsigned char digest[20];
+    sha.getDigestBytes(digest);
+    sha1Hex = ToHex(digest, sizeof(digest));
+
+    unsigned char blakeDigest[blake3::OUT_LEN];
+    blake.getDigestBytes(blakeDigest);
+    blake3Hex = ToHex(blakeDigest, sizeof(blakeDigest));
+    return true;
+}
+
+// execution mode from an optional `<plugin>.json` sidecar, as in the Python API
+static std::string ReadExecution(const std::string &pluginPath)
+{
+    std::ifstream in(pluginPath + ".json");
+    if (!in) {
+        return "in-process";
+    }
+    auto meta = nlohmann::json::parse(in, nullptr, false);
+    if (!meta.is_object()) {
+        return "in-process";
+    }
+    return meta.value("execution", "in-process");
+}
+
+DigestIndex::DigestIndex(std::string root)
+    : root_(std::move(root))
+{
+    while (root_.size() > 1 && root_.back() == '/') {
+        root_.pop_back();
+    }
+}
+
+DigestIndex::~DigestIndex()
+{
+    if (hasher_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        hasher_.join();
+    }
+    for (int fd : {inotifyFd_, hashedFd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool DigestIndex::start()
+{
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        std::perror("[registry] inotify_init1");
+        return false;
+    }
+
+    rootWatch_ = inotify_add_watch(inotifyFd_, root_.c_str(), ROOT_EVENTS);
+    if (rootWatch_ < 0) {
+        std::fprintf(stderr, "[registry] Cannot watch %s: %s\n", root_.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    hashedFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (hashedFd_ < 0) {
+        std::perror("[registry] eventfd");
+        return false;
+    }
+
+    if (!scanRoot()) {
+        return false;
+    }
+    hasher_ = std::thread(&DigestIndex::hashLoop, this);
+    return true;
+}
+
+bool DigestIndex::hashEntry(const std::string &path, Entry &entry)
+{
+    struct stat st;
+    if (!HashFile(path, st, entry.sha1, entry.blake3)) {
+        return false;
+    }
+    entry.size = st.st_size;
+    entry.mtimeNs = MtimeNs(st);
+    entry.execution = ReadExecution(path);
+    return true;
+}
+
+void DigestIndex::hashLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        Hashed result;
+        std::tie(result.arch, result.name) = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        result.ok = hashEntry(root_ + "/" + result.arch + "/" + result.name, result.entry);
+
+        lock.lock();
+        hashed_.push_back(std::move(result));
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(hashedFd_, &one, sizeof(one));
+    }
+}
+
+bool DigestIndex::scanRoot()
+{
+    DIR* dir = opendir(root_.c_str());
+    if (!dir) {
+        return false;
+    }
+    std::vector<std::string> present;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != ".." && IsDirectory(root_ + "/" + name)) {
+            present.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    std::vector<std::string> gone;
+    for (const auto& [name, arch] : arches_) {
+        if (std::find(present.begin(), present.end(), name) == present.end()) {
+            gone.push_back(name);
+        }
+    }
+    for (const auto& name : gone) {
+        removeArch(name);
+    }
+    for (const auto& name : present) {
+        addArch(name);
+    }
+    return true;
+}
+
+void DigestIndex::addArch(const std::string &name)
+{
+    Arch& arch = arches_[name];
+    std::string path = root_ + "/" + name;
+    if (arch.watch < 0) {
+        // watch before scanning, so files landing in between are not missed
+        arch.watch = inotify_add_watch(inotifyFd_, path.c_str(), ARCH_EVENTS);
+        if (arch.watch >= 0) {
+            watches_[arch.watch] = name;
+        }
+    }
+
+    // on a rescan, files that disappeared are dropped by refresh
+    std::vector<std::string> names;
+    for (const auto& [plugin, entry] : arch.plugins) {
+        names.push_back(plugin);
+    }
+    if (DIR* dir = opendir(path.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (IsPluginName(entry->d_name)) {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    for (const auto& plugin : names) {
+        refresh(arch, name, plugin);
+    }
+    arch.dirty = true;
+    allDirty_ = true;
+}
+
+void DigestIndex::removeArch(const std::string &name)
+{
+    auto it = arches_.find(name);
+    if (it == arches_.end()) {
+        return;
+    }
+    if (it->second.watch >= 0) {
+        watches_.erase(it->second.watch);
+        inotify_rm_watch(inotifyFd_, it->second.watch);
+    }
+    arches_.erase(it);
+    allDirty_ = true;
+}
+
+bool DigestIndex::refresh(Arch &arch, const std::string &archName, const std::string &name)
+{
+    std::string path = root_ + "/" + archName + "/" + name;
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return arch.plugins.erase(name) > 0;
+    }
+
+    auto it = arch.plugins.find(name);
+    if (it != arch.plugins.end() && it->second.size == static_cast<uint64_t>(st.st_size) && it->second.mtimeNs == MtimeNs(st)) {
+        return false;
+    }
+
+    if (!hasher_.joinable()) {
+        Entry entry;
+        if (!hashEntry(path, entry)) {
+            return arch.plugins.erase(name) > 0;
+        }
+        arch.plugins[name] = std::move(entry);
+        return true;
+    }
+
+    // the old entry stays listed until the new version is hashed; the server does
+    // not send the changed file in the meantime
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto key = std::make_pair(archName, name);
+    if (std::find(queue_.begin(), queue_.end(), key) == queue_.end()) {
+        queue_.push_back(std::move(key));
+        wake_.notify_one();
+    }
+    return false;
+}
+
+bool DigestIndex::handleHashed()
+{
+    uint64_t count = 0;
+    [[maybe_unused]] ssize_t got = read(hashedFd_, &count, sizeof(count));
+
+    std::vector<Hashed> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done.swap(hashed_);
+    }
+
+    bool changed = false;
+    for (auto& result : done) {
+        auto arch = arches_.find(result.arch);
+        if (arch == arches_.end()) {
+            continue;
+        }
+        // the file may have changed or gone while it was hashed; its own event
+        // queues it again, so only a result for the file on disk is applied
+        struct stat st;
+        std::string path = root_ + "/" + result.arch + "/" + result.name;
+        if (!result.ok || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            changed |= arch->second.plugins.erase(result.name) > 0;
+        } else if (result.entry.size == static_cast<uint64_t>(st.st_size) && result.entry.mtimeNs == MtimeNs(st)) {
+            arch->second.plugins[result.name] = std::move(result.entry);
+            changed = true;
+        } else {
+            continue;
+        }
+        arch->second.dirty = true;
+        allDirty_ = true;
+    }
+    return changed;
+}
+
+bool DigestIndex::handleEvents()
+{
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool changed = false;
+
+    for (;;) {
+        ssize_t len = read(inotifyFd_, buffer, sizeof(buffer));
+        if (len <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < len;) {
+            auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            std::string name = event->len ? event->name : "";
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost: rescan everything, unchanged files are not rehashed
+                scanRoot();
+                changed = true;
+                continue;
+            }
+
+            if (event->wd == rootWatch_) {
+                if (!(event->mask & IN_ISDIR) || name.empty()) {
+                    continue;
+                }
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    addArch(name);
+                } else {
+                    removeArch(name);
+                }
+                changed = true;
+                continue;
+            }
+
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end()) {
+                continue;
+            }
+            std::string archName = watch->second;
+            if (event->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+                removeArch(archName);
+                changed = true;
+                continue;
+            }
+
+            // a sidecar change refreshes the execution mode of its plugin
+            std::string pluginName = name;
+            bool sidecar = pluginName.size() > 5 && pluginName.compare(pluginName.size() - 5, 5, ".json") == 0;
+            if (sidecar) {
+                pluginName.resize(pluginName.size() - 5);
+            }
+            if (!IsPluginName(pluginName)) {
+                continue;
+            }
+
+            Arch& arch = arches_[archName];
+            if (sidecar) {
+                auto plugin = arch.plugins.find(pluginName);
+                if (plugin == arch.plugins.end()) {
+                    continue;
+                }
+                plugin->second.execution = ReadExecution(root_ + "/" + archName + "/" + pluginName);
+            } else if (!refresh(arch, archName, pluginName)) {
+                continue;
+            }
+            arch.dirty = true;
+            allDirty_ = true;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+template <typename Plugins>
+static nlohmann::json CatalogJson(const Plugins &plugins)
+{
+    nlohmann::json list = nlohmann::json::array();
+    for (const auto& [name, entry] : plugins) {
+        list.push_back({
+            {"name", name},
+            {"size", entry.size},
+            {"sha1", entry.sha1},
+            {"digest", "blake3:" + entry.blake3},
+            {"version", name},
+            {"execution", entry.execution},
+        });
+    }
+    return list;
+}
+
+const std::string& DigestIndex::catalog(const std::string &name)
+{
+    static const std::string empty = "[]";
+    auto it = arches_.find(name);
+    if (it == arches_.end()) {
+        return empty;
+    }
+
+    Arch& arch = it->second;
+    if (arch.dirty) {
+        arch.json = CatalogJson(arch.plugins).dump();
+        arch.dirty = false;
+    }
+    return arch.json;
+}
+
+const std::string& DigestIndex::catalogAll()
+{
+    if (allDirty_) {
+        nlohmann::json all = nlohmann::json::object();
+        for (const auto& [name, arch] : arches_) {
+            all[name] = CatalogJson(arch.plugins);
+        }
+        allJson_ = all.dump();
+        allDirty_ = false;
+    }
+    return allJson_;
+}
+
+std::string DigestIndex::pluginPath(const std::string &arch, const std::string &name) const
+{
+    auto it = arches_.find(arch);
+    if (it == arches_.end() || !it->second.plugins.contains(name)) {
+        return {};
+    }
+    return root_ + "/" + arch + "/" + name;
+}
+
+bool DigestIndex::isIndexedVersion(const std::string &arch, const std::string &name, uint64_t size, int64_t mtimeNs) const
+{
+    auto it = arches_.find(arch);
+    if (it == arches_.end()) {
+        return false;
+    }
+    auto plugin = it->second.plugins.find(name);
+    return plugin != it->second.plugins.end() && plugin->second.size == size && plugin->second.mtimeNs == mtimeNs;
+}
+
+size_t DigestIndex::pluginCount() const
+{
+    size_t count = 0;
+    for (const auto& [name, arch] : arches_) {
+        count += arch.plugins.size();
+    }
+    return count;
+}
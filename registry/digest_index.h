@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// DigestIndex keeps the catalog of a registry directory (<root>/<arch>/<plugin>) in
+// memory. Each file version is hashed once; inotify events refresh only the files
+// that changed, and the catalog JSON per architecture is rebuilt lazily, so serving
+// a catalog never touches the disk. Only files in the index are ever served.
+//
+// The initial scan hashes in start(). After that, new and changed files are hashed
+// on a helper thread, so the event loop never waits for a large upload; results are
+// signalled on hashedFd() and applied by handleHashed() on the loop.
+class DigestIndex {
+public:
+    explicit DigestIndex(std::string root);
+    ~DigestIndex();
+
+    DigestIndex(const DigestIndex&) = delete;
+    DigestIndex& operator=(const DigestIndex&) = delete;
+
+    // Initial scan and inotify watches; false if the root cannot be watched.
+    bool start();
+    int fd() const { return inotifyFd_; }
+    // Drains pending inotify events; returns true if the catalog changed.
+    bool handleEvents();
+    int hashedFd() const { return hashedFd_; }
+    // Applies files hashed by the helper thread; returns true if the catalog changed.
+    bool handleHashed();
+
+    const std::string& catalog(const std::string &arch);
+    const std::string& catalogAll();
+    // Absolute path of an indexed plugin, empty if there is none.
+    std::string pluginPath(const std::string &arch, const std::string &name) const;
+    // True if a file of this size and mtime is the version the catalog lists.
+    bool isIndexedVersion(const std::string &arch, const std::string &name, uint64_t size, int64_t mtimeNs) const;
+
+    size_t pluginCount() const;
+
+private:
+    struct Entry {
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+        std::string sha1;
+        std::string blake3;
+        std::string execution;
+    };
+
+    struct Arch {
+        std::map<std::string, Entry> plugins;
+        int watch = -1;
+        std::string json;
+        bool dirty = true;
+    };
+
+    struct Hashed {
+        std::string arch;
+        std::string name;
+        bool ok = false;
+        Entry entry;
+    };
+
+    static bool hashEntry(const std::string &path, Entry &entry);
+    void hashLoop();
+    bool scanRoot();
+    void addArch(const std::string &arch);
+    void removeArch(const std::string &arch);
+    bool refresh(Arch &arch, const std::string &archName, const std::string &name);
+
+    std::string root_;
+    int inotifyFd_ = -1;
+    int rootWatch_ = -1;
+    std::map<std::string, Arch> arches_;
+    std::unordered_map<int, std::string> watches_;
+
+    std::string allJson_;
+    bool allDirty_ = true;
+
+    // arch/name pairs waiting for the helper thread and its results, guarded by mutex_
+    std::thread hasher_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::pair<std::string, std::string>> queue_;
+    std::vector<Hashed> hashed_;
+    bool stopping_ = false;
+    int hashedFd_ = -1;
+};
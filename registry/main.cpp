@@ -0,0 +1,51 @@
+// plugin_registry: serves a plugin registry directory over the plugin API.
+//
+//   plugin_registry [<plugins dir>] [--host <address>] [--port <port>]
+//
+// The directory holds one sub-directory per architecture, e.g. build/plugins or
+// server/plugins. Defaults come from REGISTRY_BASE_PATH and PORT, like the Python API.
+#include "digest_index.h"
+#include "registry_server.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    const char* basePath = std::getenv("REGISTRY_BASE_PATH");
+    const char* portEnv = std::getenv("PORT");
+    std::string root = basePath ? basePath : "./plugins";
+    std::string host = "127.0.0.1";
+    int port = portEnv ? std::atoi(portEnv) : 8123;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            root = argv[i];
+        } else {
+            std::fprintf(stderr, "usage: %s [<plugins dir>] [--host <address>] [--port <port>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DigestIndex index(root);
+    if (!index.start()) {
+        return 1;
+    }
+    double indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "[registry] Indexed %zu plugin(s) in %s in %.1f ms\n", index.pluginCount(), root.c_str(), indexMs);
+
+    RegistryServer server(index);
+    if (!server.listen(host, port)) {
+        return 1;
+    }
+    std::fprintf(stderr, "[registry] Serving on http://%s:%d/api\n", host.c_str(), server.port());
+    return server.run();
+}
@@ -0,0 +1,512 @@
+#include "registry_server.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// requests larger than this are rejected rather than buffered
+static constexpr size_t MAX_REQUEST_BYTES = 16 * 1024;
+static constexpr size_t READ_CHUNK = 4096;
+// bounds a single sendfile call so one large download cannot starve the loop
+static constexpr size_t SENDFILE_CHUNK = 1 << 20;
+static constexpr int MAX_EVENTS = 256;
+
+static const char* StatusText(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Content Too Large";
+    case 503: return "Service Unavailable";
+    default: return "Internal Server Error";
+    }
+}
+
+static std::string PercentDecode(std::string_view text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '%' && i + 2 < text.size()) {
+            char hex[3] = {text[i + 1], text[i + 2], 0};
+            char* end = nullptr;
+            long value = std::strtol(hex, &end, 16);
+            if (end == hex + 2) {
+                out += static_cast<char>(value);
+                i += 2;
+                continue;
+            }
+        }
+        out += text[i];
+    }
+    return out;
+}
+
+static std::vector<std::string> SplitPath(std::string_view path)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        if (end > start) {
+            parts.push_back(PercentDecode(path.substr(start, end - start)));
+        }
+        start = end + 1;
+    }
+    return parts;
+}
+
+// Value of the first header called `name`, without leading spaces.
+static std::optional<std::string_view> HeaderValue(std::string_view headers, std::string_view name)
+{
+    // headers are matched case-insensitively, one per line
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t end = headers.find("\r\n", pos);
+        std::string_view line = headers.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        size_t colon = line.find(':');
+        if (colon == name.size() && strncasecmp(line.data(), name.data(), name.size()) == 0) {
+            std::string_view field = line.substr(colon + 1);
+            while (!field.empty() && field.front() == ' ') {
+                field.remove_prefix(1);
+            }
+            return field;
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 2;
+    }
+    return std::nullopt;
+}
+
+static bool HeaderEquals(std::string_view headers, std::string_view name, std::string_view value)
+{
+    auto field = HeaderValue(headers, name);
+    return field && field->size() >= value.size() && strncasecmp(field->data(), value.data(), value.size()) == 0;
+}
+
+// The API takes no request bodies; anything announcing one cannot stay on a
+// kept-alive connection, or the body would be parsed as the next request.
+static bool HasRequestBody(std::string_view headers)
+{
+    if (HeaderValue(headers, "Transfer-Encoding")) {
+        return true;
+    }
+    auto length = HeaderValue(headers, "Content-Length");
+    return length && length->find_first_not_of("0 \t") != std::string_view::npos;
+}
+
+RegistryServer::RegistryServer(DigestIndex &index)
+    : index_(index)
+{
+}
+
+RegistryServer::~RegistryServer()
+{
+    for (auto& [fd, conn] : connections_) {
+        if (conn.file >= 0) {
+            close(conn.file);
+        }
+        close(fd);
+    }
+    for (int fd : {listenFd_, epollFd_, signalFd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool RegistryServer::listen(const std::string &host, int port)
+{
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::perror("[registry] socket");
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        std::fprintf(stderr, "[registry] Invalid listen address: %s\n", host.c_str());
+        return false;
+    }
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listenFd_, SOMAXCONN) != 0) {
+        std::fprintf(stderr, "[registry] Cannot listen on %s:%d: %s\n", host.c_str(), port, std::strerror(errno));
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+    return true;
+}
+
+int RegistryServer::run()
+{
+    // peers that hang up mid-download must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    signalFd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ < 0 || signalFd_ < 0) {
+        std::perror("[registry] epoll/signalfd");
+        return 1;
+    }
+    for (int fd : {listenFd_, signalFd_, index_.fd(), index_.hashedFd()}) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    epoll_event events[MAX_EVENTS];
+    for (;;) {
+        int count = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::perror("[registry] epoll_wait");
+            return 1;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == signalFd_) {
+                std::fprintf(stderr, "[registry] Shutting down\n");
+                return 0;
+            }
+            if (fd == listenFd_) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == index_.fd() || fd == index_.hashedFd()) {
+                bool changed = fd == index_.fd() ? index_.handleEvents() : index_.handleHashed();
+                if (changed) {
+                    std::fprintf(stderr, "[registry] Index updated, %zu plugin(s)\n", index_.pluginCount());
+                }
+                continue;
+            }
+
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(fd);
+            } else if (events[i].events & EPOLLOUT) {
+                onWritable(it->second);
+            } else if (events[i].events & EPOLLIN) {
+                onReadable(it->second);
+            }
+        }
+    }
+}
+
+void RegistryServer::acceptConnections()
+{
+    for (;;) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        connections_[fd].fd = fd;
+    }
+}
+
+void RegistryServer::onReadable(Connection &conn)
+{
+    char buffer[READ_CHUNK];
+    for (;;) {
+        ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.in.append(buffer, n);
+            if (conn.in.size() > MAX_REQUEST_BYTES) {
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n < 0 || conn.in.empty()) {
+            closeConnection(conn.fd);
+            return;
+        }
+        // the peer half-closed after its last request: answer it, then close
+        conn.peerClosed = true;
+        break;
+    }
+
+    int fd = conn.fd;
+    processInput(conn);
+    closeIfDrained(fd);
+}
+
+void RegistryServer::processInput(Connection &conn)
+{
+    while (!conn.writing) {
+        size_t headerEnd = conn.in.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            if (conn.in.size() > MAX_REQUEST_BYTES) {
+                conn.keepAlive = false;
+                respond(conn, 413, "text/plain", "request too large\n", false);
+                break;
+            }
+            return;
+        }
+
+        std::string_view request(conn.in.data(), headerEnd);
+        size_t lineEnd = request.find("\r\n");
+        std::string_view line = request.substr(0, lineEnd);
+        std::string_view headers = lineEnd == std::string_view::npos ? std::string_view() : request.substr(lineEnd + 2);
+
+        size_t sp1 = line.find(' ');
+        size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+        if (sp2 == std::string_view::npos) {
+            conn.keepAlive = false;
+            respond(conn, 400, "text/plain", "bad request\n", false);
+            break;
+        }
+        std::string method(line.substr(0, sp1));
+        std::string target(line.substr(sp1 + 1, sp2 - sp1 - 1));
+        std::string_view version = line.substr(sp2 + 1);
+
+        // HTTP/1.1 keeps connections open unless told otherwise, 1.0 only on request
+        conn.keepAlive = version == "HTTP/1.1" ? !HeaderEquals(headers, "Connection", "close")
+                                               : HeaderEquals(headers, "Connection", "keep-alive");
+
+        if (HasRequestBody(headers)) {
+            conn.keepAlive = false;
+            respond(conn, 413, "text/plain", "request bodies are not accepted\n", false);
+            break;
+        }
+
+        conn.in.erase(0, headerEnd + 4);
+        handleRequest(conn, method, target);
+    }
+
+    if (conn.writing) {
+        onWritable(conn);
+    }
+}
+
+void RegistryServer::handleRequest(Connection &conn, const std::string &method, const std::string &target)
+{
+    bool headOnly = method == "HEAD";
+    if (method == "OPTIONS") {
+        respond(conn, 204, "text/plain", "", true);
+        return;
+    }
+    if (method != "GET" && !headOnly) {
+        respond(conn, 405, "text/plain", "method not allowed\n", false);
+        return;
+    }
+
+    std::string_view path(target);
+    path = path.substr(0, path.find('?'));
+    auto parts = SplitPath(path);
+    if (!parts.empty() && parts[0] == "api") {
+        parts.erase(parts.begin());
+    }
+    for (const auto& part : parts) {
+        if (part == "." || part == ".." || part.find('/') != std::string::npos) {
+            respond(conn, 404, "text/plain", "not found\n", headOnly);
+            return;
+        }
+    }
+
+    if (parts.empty() || parts[0] != "plugins" || parts.size() > 3) {
+        respond(conn, 404, "text/plain", "not found\n", headOnly);
+    } else if (parts.size() == 1) {
+        respond(conn, 200, "application/json", index_.catalogAll(), headOnly);
+    } else if (parts.size() == 2) {
+        respond(conn, 200, "application/json", index_.catalog(parts[1]), headOnly);
+    } else {
+        respondFile(conn, parts[1], parts[2], headOnly);
+    }
+}
+
+static std::string ResponseHeaders(int status, const char* contentType, uint64_t length, bool keepAlive)
+{
+    std::string headers = "HTTP/1.1 " + std::to_string(status) + " " + StatusText(status) + "\r\n";
+    headers += "Content-Type: " + std::string(contentType) + "\r\n";
+    headers += "Content-Length: " + std::to_string(length) + "\r\n";
+    headers += "Access-Control-Allow-Origin: *\r\n";
+    headers += "Access-Control-Allow-Methods: GET, HEAD, OPTIONS\r\n";
+    headers += "Access-Control-Allow-Headers: Content-Type\r\n";
+    headers += "Cross-Origin-Resource-Policy: cross-origin\r\n";
+    headers += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    return headers;
+}
+
+void RegistryServer::respond(Connection &conn, int status, const char* contentType, const std::string &body, bool headOnly)
+{
+    conn.out += ResponseHeaders(status, contentType, body.size(), conn.keepAlive);
+    if (!headOnly) {
+        conn.out += body;
+    }
+    setWriting(conn, true);
+}
+
+void RegistryServer::respondFile(Connection &conn, const std::string &arch, const std::string &name, bool headOnly)
+{
+    std::string path = index_.pluginPath(arch, name);
+    if (path.empty()) {
+        respond(conn, 404, "text/plain", "Plugin " + name + " for " + arch + " not found.\n", headOnly);
+        return;
+    }
+
+    // the descriptor pins this version of the file even if it is replaced mid-download
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (file < 0 || fstat(file, &st) != 0) {
+        if (file >= 0) {
+            close(file);
+        }
+        respond(conn, 404, "text/plain", "not found\n", headOnly);
+        return;
+    }
+
+    // a file rewritten in place is only served again once the index has rehashed
+    // it, so the bytes always match the digest in the catalog
+    int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    if (!index_.isIndexedVersion(arch, name, st.st_size, mtimeNs)) {
+        close(file);
+        respond(conn, 503, "text/plain", "Plugin " + name + " for " + arch + " is being updated.\n", headOnly);
+        return;
+    }
+
+    conn.out += ResponseHeaders(200, "application/octet-stream", st.st_size, conn.keepAlive);
+    if (headOnly) {
+        close(file);
+    } else {
+        conn.file = file;
+        conn.fileOffset = 0;
+        conn.fileEnd = st.st_size;
+    }
+    setWriting(conn, true);
+}
+
+void RegistryServer::onWritable(Connection &conn)
+{
+    while (conn.outOffset < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.outOffset, conn.out.size() - conn.outOffset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            closeConnection(conn.fd);
+            return;
+        }
+        conn.outOffset += n;
+    }
+    conn.out.clear();
+    conn.outOffset = 0;
+
+    while (conn.file >= 0 && conn.fileOffset < conn.fileEnd) {
+        size_t chunk = std::min<size_t>(SENDFILE_CHUNK, conn.fileEnd - conn.fileOffset);
+        ssize_t n = sendfile(conn.fd, conn.file, &conn.fileOffset, chunk);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n <= 0) {
+            // error, or the file was truncated under us
+            closeConnection(conn.fd);
+            return;
+        }
+    }
+    if (conn.file >= 0) {
+        close(conn.file);
+        conn.file = -1;
+    }
+
+    if (!conn.keepAlive) {
+        closeConnection(conn.fd);
+        return;
+    }
+    setWriting(conn, false);
+
+    // pipelined requests that arrived while this response was being sent
+    int fd = conn.fd;
+    processInput(conn);
+    closeIfDrained(fd);
+}
+
+void RegistryServer::setWriting(Connection &conn, bool writing)
+{
+    if (conn.writing == writing) {
+        return;
+    }
+    conn.writing = writing;
+
+    epoll_event ev{};
+    ev.events = writing ? EPOLLOUT : EPOLLIN;
+    ev.data.fd = conn.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+// answering may already have closed the connection, so it is looked up again
+void RegistryServer::closeIfDrained(int fd)
+{
+    auto it = connections_.find(fd);
+    if (it != connections_.end() && it->second.peerClosed && !it->second.writing) {
+        closeConnection(fd);
+    }
+}
+
+void RegistryServer::closeConnection(int fd)
+{
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    if (it->second.file >= 0) {
+        close(it->second.file);
+    }
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(it);
+}
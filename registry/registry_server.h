@@ -0,0 +1,67 @@
+#pragma once
+
+#include "digest_index.h"
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// RegistryServer speaks the plugin API's HTTP protocol on a single-threaded epoll
+// loop:
+//   GET /api/plugins                   every architecture's catalog
+//   GET /api/plugins/<arch>            catalog of one architecture
+//   GET /api/plugins/<arch>/<plugin>   plugin binary
+// (the /api prefix is optional). Catalogs come from the DigestIndex; binaries are
+// sent with sendfile straight from the page cache. Connections are non-blocking and
+// kept alive. The index is refreshed from inotify on the same loop; only its
+// hashing runs on a helper thread.
+class RegistryServer {
+public:
+    explicit RegistryServer(DigestIndex &index);
+    ~RegistryServer();
+
+    RegistryServer(const RegistryServer&) = delete;
+    RegistryServer& operator=(const RegistryServer&) = delete;
+
+    bool listen(const std::string &host, int port);
+    int port() const { return port_; }
+
+    // Serves until SIGINT or SIGTERM.
+    int run();
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        size_t outOffset = 0;
+        int file = -1;
+        off_t fileOffset = 0;
+        off_t fileEnd = 0;
+        bool keepAlive = true;
+        bool peerClosed = false;
+        bool writing = false;
+    };
+
+    void acceptConnections();
+    void onReadable(Connection &conn);
+    void onWritable(Connection &conn);
+    // Parses and answers buffered requests, one at a time.
+    void processInput(Connection &conn);
+    void handleRequest(Connection &conn, const std::string &method, const std::string &target);
+    void respond(Connection &conn, int status, const char* contentType, const std::string &body, bool headOnly);
+    void respondFile(Connection &conn, const std::string &arch, const std::string &name, bool headOnly);
+    void setWriting(Connection &conn, bool writing);
+    // Closes a half-closed connection once every buffered request is answered.
+    void closeIfDrained(int fd);
+    void closeConnection(int fd);
+
+    DigestIndex& index_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int signalFd_ = -1;
+    int port_ = 0;
+    std::unordered_map<int, Connection> connections_;
+};
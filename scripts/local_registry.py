@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Local stand-in for the plugin API, for startup benchmarks and offline development.
+
+Serves the same routes the host uses:
+  GET /api/plugins/<arch>          catalog (name, size, sha1, digest, version, execution)
+  GET /api/plugins/<arch>/<name>   plugin binary
+
+from a build tree's plugins directory (<build>/plugins/<arch>/*.plugin[.wasm]).
+An optional network profile adds a fixed latency to every response and caps the
+download bandwidth, so cold starts can be measured against realistic links.
+
+  python3 scripts/local_registry.py build/plugins --port 8123 --profile broadband
+  API_URL=http://127.0.0.1:8123/api ./build/native/host
+"""
+
+import argparse
+import hashlib
+import http.server
+import json
+import os
+import socketserver
+import sys
+import time
+from urllib.parse import unquote, urlparse
+
+try:
+    import blake3  # optional: without it catalogs carry "sha1:" digests
+except ImportError:
+    blake3 = None
+
+# name: (latency in ms, bandwidth in kbit/s, 0 = unlimited)
+PROFILES = {
+    "none": (0, 0),
+    "lan": (1, 1_000_000),
+    "broadband": (20, 50_000),
+    "dsl": (40, 8_000),
+    "3g": (150, 1_600),
+}
+
+CHUNK_SIZE = 16 * 1024
+
+
+def get_digests(file_path) -> tuple[str, str]:
+    """SHA1 hex for older clients, and the algorithm-tagged digest clients verify against."""
+    BUF_SIZE = 65536
+    sha1 = hashlib.sha1()
+    tagged = blake3.blake3() if blake3 else None
+
+    with open(file_path, "rb") as f:
+        while True:
+            data = f.read(BUF_SIZE)
+            if not data:
+                break
+            sha1.update(data)
+            if tagged:
+                tagged.update(data)
+
+    if tagged:
+        return sha1.hexdigest(), "blake3:" + tagged.hexdigest()
+    return sha1.hexdigest(), "sha1:" + sha1.hexdigest()
+
+
+def get_execution(file_path) -> str:
+    meta_path = file_path + ".json"
+    if not os.path.exists(meta_path):
+        return "in-process"
+
+    with open(meta_path) as f:
+        return json.load(f).get("execution", "in-process")
+
+
+class Catalog:
+    """Plugin metadata per architecture; digests are recomputed only when a file changes."""
+
+    def __init__(self, root):
+        self.root = root
+        self.digests = {}
+
+    def entry(self, path):
+        stat = os.stat(path)
+        key = (path, stat.st_size, stat.st_mtime_ns)
+        if key not in self.digests:
+            self.digests[key] = get_digests(path)
+        name = os.path.basename(path)
+        return {
+            "name": name,
+            "size": stat.st_size,
+            "sha1": self.digests[key][0],
+            "digest": self.digests[key][1],
+            "version": name,
+            "execution": get_execution(path),
+        }
+
+    def list(self, arch):
+        arch_path = os.path.join(self.root, arch)
+        if not os.path.isdir(arch_path):
+            return []
+        plugins = []
+        for name in sorted(os.listdir(arch_path)):
+            path = os.path.join(arch_path, name)
+            if os.path.isfile(path) and (name.endswith(".plugin") or name.endswith(".plugin.wasm")):
+                plugins.append(self.entry(path))
+        return plugins
+
+
+class RegistryHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, format, *args):
+        if not self.server.quiet:
+            super().log_message(format, *args)
+
+    def send_body(self, content_type, body=None, path=None, size=0):
+        if self.server.latency_ms:
+            time.sleep(self.server.latency_ms / 1000.0)
+
+        self.send_response(200)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(size if path else len(body)))
+        self.send_header("Access-Control-Allow-Origin", "*")
+        self.end_headers()
+
+        if path is None:
+            self.write_throttled([body])
+            return
+        with open(path, "rb") as f:
+            self.write_throttled(iter(lambda: f.read(CHUNK_SIZE), b""))
+
+    def write_throttled(self, chunks):
+        bytes_per_second = self.server.bandwidth_kbps * 1000 / 8
+        start = time.monotonic()
+        sent = 0
+        for chunk in chunks:
+            for offset in range(0, len(chunk), CHUNK_SIZE):
+                piece = chunk[offset : offset + CHUNK_SIZE]
+                self.wfile.write(piece)
+                sent += len(piece)
+                if bytes_per_second:
+                    ahead = sent / bytes_per_second - (time.monotonic() - start)
+                    if ahead > 0:
+                        time.sleep(ahead)
+
+    def do_GET(self):
+        parts = [unquote(p) for p in urlparse(self.path).path.split("/") if p]
+        if len(parts) < 3 or parts[:2] != ["api", "plugins"] or any(p in (".", "..") for p in parts):
+            self.send_error(404, "Not found")
+            return
+
+        arch = parts[2]
+        if len(parts) == 3:
+            body = json.dumps(self.server.catalog.list(arch)).encode("utf-8")
+            self.send_body("application/json", body=body)
+            return
+
+        path = os.path.join(self.server.catalog.root, arch, parts[3])
+        if len(parts) != 4 or not os.path.isfile(path):
+            self.send_error(404, f"Plugin {parts[-1]} for {arch} not found.")
+            return
+        self.send_body("application/octet-stream", path=path, size=os.path.getsize(path))
+
+
+class RegistryServer(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("plugins", help="directory with one sub-directory of plugins per architecture")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=int(os.getenv("PORT", 8123)))
+    parser.add_argument("--profile", choices=sorted(PROFILES), default="none")
+    parser.add_argument("--latency-ms", type=float, help="per-response latency, overrides the profile")
+    parser.add_argument("--bandwidth-kbps", type=float, help="download cap in kbit/s, 0 = unlimited, overrides the profile")
+    parser.add_argument("--quiet", action="store_true", help="do not log requests")
+    args = parser.parse_args()
+
+    latency_ms, bandwidth_kbps = PROFILES[args.profile]
+    if args.latency_ms is not None:
+        latency_ms = args.latency_ms
+    if args.bandwidth_kbps is not None:
+        bandwidth_kbps = args.bandwidth_kbps
+
+    server = RegistryServer((args.host, args.port), RegistryHandler)
+    server.catalog = Catalog(os.path.abspath(args.plugins))
+    server.latency_ms = latency_ms
+    server.bandwidth_kbps = bandwidth_kbps
+    server.quiet = args.quiet
+
+    print(
+        f"Serving {server.catalog.root} on http://{args.host}:{server.server_address[1]}/api "
+        f"(latency {latency_ms} ms, bandwidth {bandwidth_kbps or 'unlimited'} kbit/s)",
+        flush=True,
+    )
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
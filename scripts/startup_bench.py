@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Measures time from main() to the first frame with every plugin ready.
+
+Each run starts the host with PLUGIN_STARTUP_REPORT/PLUGIN_STARTUP_EXIT set, so it
+writes its startup timeline and quits as soon as all plugins are loaded. Scenarios:
+  cold     empty install directory, every plugin is downloaded from the registry
+  warm     plugins already installed, the catalog is still fetched and checked
+  offline  plugins already installed, the registry is unreachable
+
+The registry is scripts/local_registry.py serving <build>/plugins, optionally with
+a latency/bandwidth profile, or the native plugin_registry with --registry native.
+Configure the build with e.g. -DPLUGIN_SYNTHETIC_COUNT=50 to add a synthetic
+plugin fleet.
+
+  python3 scripts/startup_bench.py build --runs 10 --profile broadband
+"""
+
+import argparse
+import json
+import os
+import shutil
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+SCENARIOS = ("cold", "warm", "offline")
+HOSTS = ("headless", "native")
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def wait_for_port(port, timeout=10.0):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=0.2):
+                return True
+        except OSError:
+            time.sleep(0.05)
+    return False
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(p * len(ordered)))]
+
+
+def phases(report):
+    """Reduces a startup report to wall-clock time per phase, in ms."""
+    spans = report.get("spans", [])
+
+    def named(prefix):
+        return [s for s in spans if s["name"] == prefix or s["name"].startswith(prefix + ":")]
+
+    def wall(selected):
+        if not selected:
+            return 0.0
+        return max(s["endMs"] for s in selected) - min(s["startMs"] for s in selected)
+
+    def first(name):
+        return next((s["startMs"] for s in spans if s["name"] == name), None)
+
+    requested = first("catalog_requested")
+    received = first("catalog_received") or first("catalog_failed")
+    return {
+        "main": first("main") or 0.0,
+        "catalog": received - requested if requested is not None and received is not None else 0.0,
+        "local": wall(named("local_plugins")),
+        "download": wall(named("download")),
+        "verify": sum(s["endMs"] - s["startMs"] for s in named("verify")),
+        "load": sum(s["endMs"] - s["startMs"] for s in named("load")),
+        "firstFrame": report.get("firstFrameMs", 0.0),
+        "ready": report.get("readyMs", 0.0),
+        "plugins": len(named("load")),
+    }
+
+
+def native_command(host):
+    if os.environ.get("DISPLAY") or os.environ.get("WAYLAND_DISPLAY"):
+        return [host]
+    if shutil.which("xvfb-run"):
+        return ["xvfb-run", "-a", host]
+    return None
+
+
+def run_once(args, host_kind, scenario, api_url, arch_dir, work_dir, run):
+    install_dir = os.path.join(work_dir, f"{host_kind}-{scenario}-{run}")
+    shutil.rmtree(install_dir, ignore_errors=True)
+    if scenario == "cold":
+        os.makedirs(install_dir)
+    else:
+        shutil.copytree(arch_dir, install_dir, ignore=shutil.ignore_patterns("*.json"))
+
+    report_path = install_dir + ".json"
+    env = dict(os.environ)
+    env.update(
+        {
+            "API_URL": api_url if scenario != "offline" else "http://127.0.0.1:9/api",
+            "PLUGIN_INSTALL_DIR": install_dir,
+            "PLUGIN_STARTUP_REPORT": report_path,
+            "PLUGIN_STARTUP_EXIT": "1",
+            "PLUGIN_STARTUP_LABEL": f"{host_kind}/{scenario}",
+            "PLUGIN_INSTALL_ALL": "1",
+        }
+    )
+
+    host = os.path.join(args.build, "native", "host")
+    if host_kind == "headless":
+        command = [host, "--headless", "--frames", "1000000", "--timeout-ms", str(args.timeout * 1000)]
+        command += ["--offline"] if scenario == "offline" else ["--install-all"]
+    else:
+        command = native_command(host)
+
+    try:
+        subprocess.run(command, env=env, timeout=args.timeout, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    except subprocess.TimeoutExpired:
+        print(f"  {host_kind}/{scenario} run {run}: timed out", file=sys.stderr)
+        return None
+
+    if not os.path.exists(report_path):
+        print(f"  {host_kind}/{scenario} run {run}: no startup report", file=sys.stderr)
+        return None
+    with open(report_path) as f:
+        report = json.load(f)
+    return {"report": report, "phases": phases(report)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("build", help="native build directory (contains native/host and plugins/)")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--hosts", default=",".join(HOSTS), help="comma-separated subset of: " + ", ".join(HOSTS))
+    parser.add_argument("--scenarios", default=",".join(SCENARIOS), help="comma-separated subset of: " + ", ".join(SCENARIOS))
+    parser.add_argument("--arch", help="plugin architecture directory, default: the only one in <build>/plugins")
+    parser.add_argument("--registry", choices=("python", "native"), default="python",
+                        help="python: scripts/local_registry.py (supports shaping), native: <build>/native/plugin_registry")
+    parser.add_argument("--profile", default="none", help="network profile passed to local_registry.py")
+    parser.add_argument("--latency-ms", type=float)
+    parser.add_argument("--bandwidth-kbps", type=float)
+    parser.add_argument("--timeout", type=int, default=60, help="seconds per run")
+    parser.add_argument("--output", default="startup_results.json")
+    args = parser.parse_args()
+
+    args.build = os.path.abspath(args.build)
+    plugins_dir = os.path.join(args.build, "plugins")
+    arches = sorted(d for d in os.listdir(plugins_dir) if os.path.isdir(os.path.join(plugins_dir, d)))
+    arch = args.arch or (arches[0] if len(arches) == 1 else None)
+    if arch is None:
+        parser.error(f"pass --arch, {plugins_dir} has: {', '.join(arches) or 'nothing'}")
+    arch_dir = os.path.join(plugins_dir, arch)
+
+    hosts = [h for h in args.hosts.split(",") if h]
+    if "native" in hosts and native_command(os.path.join(args.build, "native", "host")) is None:
+        print("No display and no xvfb-run, skipping the native host", file=sys.stderr)
+        hosts.remove("native")
+
+    port = free_port()
+    if args.registry == "native":
+        if args.profile != "none" or args.latency_ms is not None or args.bandwidth_kbps is not None:
+            parser.error("network shaping needs --registry python")
+        registry = [os.path.join(args.build, "native", "plugin_registry"), plugins_dir, "--port", str(port)]
+    else:
+        registry = [sys.executable, os.path.join(SCRIPT_DIR, "local_registry.py"), plugins_dir,
+                    "--port", str(port), "--profile", args.profile, "--quiet"]
+        if args.latency_ms is not None:
+            registry += ["--latency-ms", str(args.latency_ms)]
+        if args.bandwidth_kbps is not None:
+            registry += ["--bandwidth-kbps", str(args.bandwidth_kbps)]
+    server = subprocess.Popen(registry, stderr=subprocess.DEVNULL if args.registry == "native" else None)
+
+    results = {"arch": arch, "registry": args.registry, "profile": args.profile, "runs": []}
+    try:
+        if not wait_for_port(port):
+            print("Registry did not start", file=sys.stderr)
+            return 1
+        api_url = f"http://127.0.0.1:{port}/api"
+
+        with tempfile.TemporaryDirectory(prefix="startup_bench_") as work_dir:
+            for host_kind in hosts:
+                for scenario in [s for s in args.scenarios.split(",") if s]:
+                    print(f"{host_kind}/{scenario}: {args.runs} run(s)", file=sys.stderr)
+                    for run in range(args.runs):
+                        result = run_once(args, host_kind, scenario, api_url, arch_dir, work_dir, run)
+                        if result:
+                            results["runs"].append({"host": host_kind, "scenario": scenario, **result})
+    finally:
+        server.terminate()
+        server.wait()
+
+    columns = ("catalog", "local", "download", "verify", "load", "firstFrame", "ready")
+    print(f"{'host/scenario':<18}{'n':>4}{'plugins':>9}" + "".join(f"{c + ' p50/p90':>22}" for c in columns))
+    summary = {}
+    for key in sorted({(r["host"], r["scenario"]) for r in results["runs"]}):
+        runs = [r["phases"] for r in results["runs"] if (r["host"], r["scenario"]) == key]
+        stats = {c: {"p50": statistics.median([p[c] for p in runs]), "p90": percentile([p[c] for p in runs], 0.9)} for c in columns}
+        summary["/".join(key)] = stats
+        cells = "".join(f"{stats[c]['p50']:>12.1f} /{stats[c]['p90']:>8.1f}" for c in columns)
+        print(f"{'/'.join(key):<18}{len(runs):>4}{runs[0]['plugins']:>9}{cells}")
+    results["summary"] = summary
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2)
+    print(f"Wrote {args.output}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,4 +1,11 @@
 #include "lib/app_host.h"
+#include "lib/task_pool.h"
+#include "lib/event_bus.h"
+#include "lib/plugin_allocator.h"
+#include "lib/worker_supervisor.h"
+#include "lib/startup_timeline.h"
+#include "lib/metrics.h"
+#include "lib/plugin_updater.h"
 
 #ifdef EMSCRIPTEN
 #include <emscripten.h>
@@ -6,30 +13,59 @@
 
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <cstdlib>
 
 #include <hello_imgui/hello_imgui.h>
 #include "hello_imgui/runner_params.h"
 
+#ifndef PLUGIN_HOST_WORKERS
+#define PLUGIN_HOST_WORKERS 4
+#endif
+
 static AppHost* gStaticHost = nullptr;
 
+// frame rate bounds while no input arrives and no plugin requested a redraw
+static constexpr float IDLE_FPS = 4.f;
+static constexpr float MAX_IDLE_FPS = 30.f;
+
 static uint64_t GetTimeMs()
 {
 return std::chrono::duration_cast<std::chrono::milliseconds>(
     std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
+static double GetTimeSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void AppHost::ShowPluginManagerWindow()
 {
     if (!m_loadedDownloadedPlugins) {
-        if (!PluginManager::getInstance().getPluginList().empty() || GetTimeMs() > m_serverTimeoutMs) {
-            PluginManager::getInstance().loadPreDownloadedPlugins();
+        auto& manager = PluginManager::getInstance();
+        if (!manager.getPluginList().empty() || !manager.catalogPending() || GetTimeMs() > m_serverTimeoutMs) {
+            manager.loadPreDownloadedPlugins();
             m_loadedDownloadedPlugins = true;
+            // startup is done with the install directory, later updates are staged for the next start
+            PluginUpdater::getInstance().start();
+
+            // PLUGIN_INSTALL_ALL=1 installs the whole catalog, e.g. for startup benchmarks
+            const char* installAll = std::getenv("PLUGIN_INSTALL_ALL");
+            if (installAll && std::string(installAll) == "1") {
+                for (auto& plugin : manager.getPluginList()) {
+                    if (!plugin.loaded) {
+                        manager.downloadAndLoadPlugin(plugin);
+                    }
+                }
+            }
         }
     }
 
 
     if (ImGui::Button("Refresh Plugin List")) {
         PluginManager::getInstance().fetchPluginList();
+        PluginUpdater::getInstance().checkNow();
     }
 
     ImGui::Text("Available Plugins:");
@@ -45,20 +81,98 @@ void AppHost::ShowPluginManagerWindow()
     if (ImGui::Button("Download & Load") && selectedPlugin >= 0) {
         PluginManager::getInstance().downloadAndLoadPlugin(list[selectedPlugin]);
     }
+
+    if (size_t staged = PluginUpdater::getInstance().stagedCount()) {
+        ImGui::TextDisabled("%zu plugin update(s) staged, applied at the next start", staged);
+    }
+
+    auto usage = AllocatorService::getInstance().usage();
+    if (!usage.empty() && ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen)) {
+        if (ImGui::BeginTable("PluginMemory", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Plugin");
+            ImGui::TableSetupColumn("In Use (KiB)");
+            ImGui::TableSetupColumn("Peak (KiB)");
+            ImGui::TableSetupColumn("Reserved (KiB)");
+            ImGui::TableSetupColumn("Live Allocs");
+            ImGui::TableSetupColumn("Total Allocs");
+            ImGui::TableHeadersRow();
+            for (const auto& entry : usage) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.owner.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", entry.bytesInUse / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", entry.peakBytes / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", entry.bytesReserved / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(entry.liveAllocations));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(entry.totalAllocations));
+            }
+            ImGui::EndTable();
+        }
+    }
 }
 
 static void ShowRenderables()
 {
-    for (auto& renderable : PluginManager::getInstance().getRenderables()) {
-        if (ImGui::Begin("Plugin Renderable")) {
+    auto& renderables = PluginManager::getInstance().getRenderables();
+    if (renderables.empty()) {
+        return;
+    }
+
+    if (ImGui::Begin("Plugin Renderable")) {
+        for (auto& renderable : renderables) {
             renderable();
         }
-        ImGui::End();
     }
+    ImGui::End();
+}
+
+void AppHost::ShowPluginWindows()
+{
+    ShowRenderables();
+    Scheduler::getInstance().drawAll();
+    DrawListComposer::getInstance().composeAll();
+}
+
+void AppHost::UpdatePlugins(double nowSeconds)
+{
+    TaskPool::getInstance().drainMainThread();
+    Logger::getInstance().pump();
+    Metrics::getInstance().pump();
+    AllocatorService::getInstance().beginFrame();
+
+    Scheduler::getInstance().runDueTicks(nowSeconds);
+    EventBus::getInstance().dispatch();
+    WorkerSupervisor::getInstance().update();
+    DrawListComposer::getInstance().submitFrame();
+}
+
+void AppHost::UpdateFrame()
+{
+    double now = GetTimeSeconds();
+    UpdatePlugins(now);
+
+    // idle at the slowest rate that still serves the next tick, unless a plugin asked for a frame
+    auto& scheduler = Scheduler::getInstance();
+    auto& idling = HelloImGui::GetRunnerParams()->fpsIdling;
+    idling.enableIdling = !scheduler.consumeRedrawRequest();
+
+    double wait = scheduler.secondsUntilNextTick(now);
+    float fps = wait < 0.0 ? IDLE_FPS : wait > 0.0 ? static_cast<float>(1.0 / wait) : MAX_IDLE_FPS;
+    idling.fpsIdle = std::clamp(fps, IDLE_FPS, MAX_IDLE_FPS);
 }
 
 AppHost::AppHost()
 {
+    Logger::getInstance().start();
+    if (Metrics::getInstance().start()) {
+        Scheduler::getInstance().setProfiling(true);
+    }
+
     gStaticHost = this;
     m_serverTimeoutMs = GetTimeMs() + 1000;
 
@@ -86,7 +200,52 @@ AppHost::AppHost()
 #endif
 }
 
+void AppHost::ShowLogWindow()
+{
+    static int minLevel = static_cast<int>(LogLevel::Info);
+    static ImGuiTextFilter filter;
+    static bool autoScroll = true;
+
+    static const char* levels[] = { "Trace", "Debug", "Info", "Warn", "Error" };
+    ImGui::SetNextItemWidth(100);
+    ImGui::Combo("Level", &minLevel, levels, IM_ARRAYSIZE(levels));
+    ImGui::SameLine();
+    filter.Draw("Filter", 200);
+    ImGui::SameLine();
+    ImGui::Checkbox("Auto-scroll", &autoScroll);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) {
+        Logger::getInstance().clearHistory();
+    }
+    if (uint64_t dropped = Logger::getInstance().droppedCount()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%llu dropped)", static_cast<unsigned long long>(dropped));
+    }
+
+    ImGui::Separator();
+    if (ImGui::BeginChild("LogScroll", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar)) {
+        Logger::getInstance().forEachRecent([](const LogRecord& record) {
+            if (static_cast<int>(record.level) < minLevel) {
+                return;
+            }
+            if (!filter.PassFilter(record.tag) && !filter.PassFilter(record.message)) {
+                return;
+            }
+            ImVec4 color = record.level >= LogLevel::Error ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f)
+                         : record.level == LogLevel::Warn  ? ImVec4(1.0f, 0.8f, 0.3f, 1.0f)
+                         : record.level <= LogLevel::Debug ? ImVec4(0.6f, 0.6f, 0.6f, 1.0f)
+                                                           : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+            ImGui::TextColored(color, "[%8.3f][%s] %s", record.timestampMs / 1000.0, record.tag, record.message);
+        });
+        if (autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
+            ImGui::SetScrollHereY(1.0f);
+        }
+    }
+    ImGui::EndChild();
+}
+
 static std::shared_ptr<HelloImGui::DockableWindow> s_featuresDemoWindow;
+static std::shared_ptr<HelloImGui::DockableWindow> s_logWindow;
 
 void AppHost::CreateDockableWindows()
 {
@@ -102,7 +261,15 @@ void AppHost::CreateDockableWindows()
 
         HelloImGui::AddDockableWindow(s_featuresDemoWindow, true);
 
-        printf("[AppHost] Created dockable window: %s\n", s_featuresDemoWindow->label.c_str());
+        s_logWindow = std::make_shared<HelloImGui::DockableWindow>();
+        s_logWindow->label = "Log";
+        s_logWindow->dockSpaceName = "CommandSpace";
+        s_logWindow->GuiFunction = [&] { ShowLogWindow(); };
+        s_logWindow->isVisible = true;
+
+        HelloImGui::AddDockableWindow(s_logWindow, true);
+
+        HOST_LOG(LogLevel::Debug, "AppHost", "Created dockable window: " + s_featuresDemoWindow->label);
     }
 }
 
@@ -120,7 +287,7 @@ HelloImGui::DockingParams AppHost::CreateDefaultLayout()
 
 int AppHost::run()
 {
-    printf("[AppHost] Starting application...\n");
+    HOST_LOG(LogLevel::Info, "AppHost", "Starting application...");
 
     HelloImGui::RunnerParams runnerParams;
     runnerParams.appWindowParams.windowTitle = "Plugin Host";
@@ -139,11 +306,28 @@ int AppHost::run()
     runnerParams.iniFolderType = HelloImGui::IniFolderType::AppUserConfigFolder;
     runnerParams.iniFilename = "plugins-dev/plugins-dev.ini";
 
+    // update phase: background results, plugin ticks and idle throttling
+    runnerParams.callbacks.PreNewFrame = [this] { UpdateFrame(); };
+    runnerParams.callbacks.ShowGui = [this] {
+        ShowPluginWindows();
+        bool settled = m_loadedDownloadedPlugins && PluginManager::getInstance().pendingInstalls() == 0;
+        if (StartupTimeline::getInstance().frameRendered("gui", settled)) {
+            HelloImGui::GetRunnerParams()->appShallExit = true;
+        }
+    };
+    runnerParams.fpsIdling.enableIdling = true;
+    runnerParams.fpsIdling.fpsIdle = IDLE_FPS;
+
+    TaskPool::getInstance().start(PLUGIN_HOST_WORKERS);
     PluginManager::getInstance().fetchPluginList();
 
     HelloImGui::Run(runnerParams);
 
+    PluginUpdater::getInstance().stop();
+    TaskPool::getInstance().stop();
     PluginManager::getInstance().unloadAll();
+    Metrics::getInstance().stop();
+    Logger::getInstance().stop();
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "lib/draw_buffer.h"
+
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<DrawBuffer::Command>);
+static_assert(std::is_trivially_copyable_v<ImVec2>);
+
+struct WireHeader {
+    ImVec2 contentSize;
+    uint32_t commandCount;
+    uint32_t pointCount;
+    uint32_t textSize;
+};
+
+static ImVec2 Offset(ImVec2 p, ImVec2 origin)
+{
+    return ImVec2(p.x + origin.x, p.y + origin.y);
+}
+
+void DrawBuffer::clear()
+{
+    commands_.clear();
+    points_.clear();
+    text_.clear();
+    contentSize_ = ImVec2(0, 0);
+}
+
+void DrawBuffer::line(ImVec2 a, ImVec2 b, ImU32 color, float thickness)
+{
+    commands_.push_back(Command{Type::Line, color, thickness, a, b, 0, 0});
+}
+
+void DrawBuffer::rect(ImVec2 min, ImVec2 max, ImU32 color, float thickness)
+{
+    commands_.push_back(Command{Type::Rect, color, thickness, min, max, 0, 0});
+}
+
+void DrawBuffer::rectFilled(ImVec2 min, ImVec2 max, ImU32 color)
+{
+    commands_.push_back(Command{Type::RectFilled, color, 0.0f, min, max, 0, 0});
+}
+
+void DrawBuffer::circle(ImVec2 center, float radius, ImU32 color, float thickness)
+{
+    commands_.push_back(Command{Type::Circle, color, thickness, center, ImVec2(radius, 0), 0, 0});
+}
+
+void DrawBuffer::circleFilled(ImVec2 center, float radius, ImU32 color)
+{
+    commands_.push_back(Command{Type::CircleFilled, color, 0.0f, center, ImVec2(radius, 0), 0, 0});
+}
+
+void DrawBuffer::polyline(const ImVec2* points, size_t count, ImU32 color, float thickness)
+{
+    auto first = static_cast<uint32_t>(points_.size());
+    points_.insert(points_.end(), points, points + count);
+    commands_.push_back(Command{Type::Polyline, color, thickness, ImVec2(), ImVec2(), first, static_cast<uint32_t>(count)});
+}
+
+void DrawBuffer::text(ImVec2 pos, ImU32 color, std::string_view str)
+{
+    auto first = static_cast<uint32_t>(text_.size());
+    text_.append(str);
+    commands_.push_back(Command{Type::Text, color, 0.0f, pos, ImVec2(), first, static_cast<uint32_t>(str.size())});
+}
+
+void DrawBuffer::replay(ImDrawList* drawList, ImVec2 origin) const
+{
+    std::vector<ImVec2> scratch;
+    for (const auto& cmd : commands_) {
+        switch (cmd.type) {
+        case Type::Line:
+            drawList->AddLine(Offset(cmd.a, origin), Offset(cmd.b, origin), cmd.color, cmd.thickness);
+            break;
+        case Type::Rect:
+            drawList->AddRect(Offset(cmd.a, origin), Offset(cmd.b, origin), cmd.color, 0.0f, 0, cmd.thickness);
+            break;
+        case Type::RectFilled:
+            drawList->AddRectFilled(Offset(cmd.a, origin), Offset(cmd.b, origin), cmd.color);
+            break;
+        case Type::Circle:
+            drawList->AddCircle(Offset(cmd.a, origin), cmd.b.x, cmd.color, 0, cmd.thickness);
+            break;
+        case Type::CircleFilled:
+            drawList->AddCircleFilled(Offset(cmd.a, origin), cmd.b.x, cmd.color);
+            break;
+        case Type::Polyline:
+            scratch.resize(cmd.count);
+            for (uint32_t i = 0; i < cmd.count; i++) {
+                scratch[i] = Offset(points_[cmd.first + i], origin);
+            }
+            drawList->AddPolyline(scratch.data(), static_cast<int>(cmd.count), cmd.color, 0, cmd.thickness);
+            break;
+        case Type::Text: {
+            const char* begin = text_.data() + cmd.first;
+            drawList->AddText(Offset(cmd.a, origin), cmd.color, begin, begin + cmd.count);
+            break;
+        }
+        }
+    }
+}
+
+void DrawBuffer::serialize(std::vector<uint8_t> &out) const
+{
+    WireHeader header{contentSize_, static_cast<uint32_t>(commands_.size()),
+        static_cast<uint32_t>(points_.size()), static_cast<uint32_t>(text_.size())};
+
+    size_t offset = out.size();
+    out.resize(offset + sizeof(header) + commands_.size() * sizeof(Command) + points_.size() * sizeof(ImVec2) + text_.size());
+    uint8_t* dest = out.data() + offset;
+    std::memcpy(dest, &header, sizeof(header));
+    dest += sizeof(header);
+    std::memcpy(dest, commands_.data(), commands_.size() * sizeof(Command));
+    dest += commands_.size() * sizeof(Command);
+    std::memcpy(dest, points_.data(), points_.size() * sizeof(ImVec2));
+    dest += points_.size() * sizeof(ImVec2);
+    std::memcpy(dest, text_.data(), text_.size());
+}
+
+bool DrawBuffer::deserialize(const uint8_t* data, size_t size)
+{
+    WireHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    size_t expected = sizeof(header) + size_t(header.commandCount) * sizeof(Command)
+        + size_t(header.pointCount) * sizeof(ImVec2) + header.textSize;
+    if (size != expected) {
+        return false;
+    }
+
+    const uint8_t* src = data + sizeof(header);
+    commands_.resize(header.commandCount);
+    std::memcpy(commands_.data(), src, commands_.size() * sizeof(Command));
+    src += commands_.size() * sizeof(Command);
+    points_.resize(header.pointCount);
+    std::memcpy(points_.data(), src, points_.size() * sizeof(ImVec2));
+    src += points_.size() * sizeof(ImVec2);
+    text_.assign(reinterpret_cast<const char*>(src), header.textSize);
+    contentSize_ = header.contentSize;
+
+    for (const auto& command : commands_) {
+        uint64_t end = uint64_t(command.first) + command.count;
+        bool valid = command.type == Type::Polyline ? end <= points_.size()
+            : command.type == Type::Text ? end <= text_.size()
+            : command.type <= Type::Text;
+        if (!valid) {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#include "lib/draw_list_composer.h"
+#include "lib/scheduler.h"
+#include "lib/task_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+DrawListComposer& DrawListComposer::getInstance() {
+    static DrawListComposer instance;
+    return instance;
+}
+
+DrawListComposer::Handle DrawListComposer::registerPrepared(const std::string &owner, const std::string &label, PrepareFunc func)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->handle = nextHandle_++;
+    entry->owner = owner;
+    entry->label = label;
+    entry->func = std::move(func);
+    entries_.push_back(entry);
+    return entry->handle;
+}
+
+void DrawListComposer::clear()
+{
+    // a job's shared_ptr keeps its entry alive, but not the plugin code behind
+    // func, so func is destroyed here and queued jobs find it empty
+    for (auto& entry : entries_) {
+        std::lock_guard<std::mutex> lock(entry->funcMutex);
+        entry->func = nullptr;
+    }
+    entries_.clear();
+}
+
+void DrawListComposer::submitFrame()
+{
+    for (auto& entry : entries_) {
+        if (!entry->func || entry->busy.exchange(true)) {
+            continue;
+        }
+
+        ImVec2 available = entry->available;
+        TaskPool::getInstance().submit([entry, available]() -> TaskPool::Task {
+            auto start = std::chrono::steady_clock::now();
+            bool changed = false;
+            {
+                std::lock_guard<std::mutex> lock(entry->funcMutex);
+                if (entry->func) {
+                    entry->back.clear();
+                    changed = entry->func(entry->back, available);
+                }
+            }
+            double elapsedMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+
+            return [entry, changed, elapsedMs]() {
+                entry->prepareMs = elapsedMs;
+                if (changed) {
+                    std::swap(entry->front, entry->back);
+                    Scheduler::getInstance().requestRedraw();
+                }
+                entry->busy.store(false);
+            };
+        });
+    }
+}
+
+void DrawListComposer::composeAll()
+{
+    for (auto& entry : entries_) {
+        if (ImGui::Begin(entry->label.c_str())) {
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            entry->available = ImGui::GetContentRegionAvail();
+            entry->front.replay(ImGui::GetWindowDrawList(), origin);
+
+            ImVec2 size = entry->front.contentSize();
+            ImGui::Dummy(ImVec2(std::max(size.x, 1.0f), std::max(size.y, 1.0f)));
+        }
+        ImGui::End();
+    }
+}
+
+void DrawListComposer::submitRemote(const std::string &owner, const std::string &label, DrawBuffer &&buffer)
+{
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const auto& entry) {
+        return entry->owner == owner && entry->label == label;
+    });
+    if (it == entries_.end()) {
+        registerPrepared(owner, label, nullptr);
+        it = std::prev(entries_.end());
+    }
+    (*it)->front = std::move(buffer);
+    Scheduler::getInstance().requestRedraw();
+}
+
+ImVec2 DrawListComposer::availableFor(const std::string &owner, const std::string &label) const
+{
+    for (const auto& entry : entries_) {
+        if (entry->owner == owner && entry->label == label) {
+            return entry->available;
+        }
+    }
+    return ImVec2(0, 0);
+}
+
+void DrawListComposer::setAvailable(const std::string &label, ImVec2 available)
+{
+    for (auto& entry : entries_) {
+        if (entry->label == label) {
+            entry->available = available;
+        }
+    }
+}
+
+void DrawListComposer::prepareNow(const std::function<void(const std::string &label, const DrawBuffer &buffer)> &emit)
+{
+    for (auto& entry : entries_) {
+        if (!entry->func) {
+            continue;
+        }
+        entry->back.clear();
+        if (entry->func(entry->back, entry->available)) {
+            std::swap(entry->front, entry->back);
+            emit(entry->label, entry->front);
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#include "lib/event_bus.h"
+#include "lib/plugin_api.h"
+
+#include <algorithm>
+#include <cstring>
+
+SharedBuffer SharedBuffer::allocate(size_t size)
+{
+    SharedBuffer buffer;
+    buffer.bytes_ = std::shared_ptr<std::byte[]>(new std::byte[size > 0 ? size : 1]);
+    buffer.size_ = size;
+    return buffer;
+}
+
+SharedBuffer SharedBuffer::copyOf(const void* data, size_t size)
+{
+    SharedBuffer buffer = allocate(size);
+    if (size > 0) {
+        std::memcpy(buffer.mutableData(), data, size);
+    }
+    return buffer;
+}
+
+EventBus& EventBus::getInstance() {
+    static EventBus instance;
+    return instance;
+}
+
+EventBus::TopicId EventBus::topicId(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(topicsMutex_);
+    auto it = topicIds_.find(name);
+    if (it != topicIds_.end()) {
+        return it->second;
+    }
+
+    auto id = static_cast<TopicId>(topicNames_.size());
+    topicNames_.emplace_back(name);
+    topicIds_.emplace(std::string(name), id);
+    return id;
+}
+
+std::string EventBus::topicName(TopicId id) const
+{
+    std::lock_guard<std::mutex> lock(topicsMutex_);
+    return id < topicNames_.size() ? topicNames_[id] : std::string();
+}
+
+bool EventBus::publish(TopicId topic, SharedBuffer payload)
+{
+    if (!queue_.tryPush(Event{topic, std::move(payload)})) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+EventBus::Subscription EventBus::subscribe(const std::string &owner, TopicId topic, Callback callback)
+{
+    Subscription id = nextSubscription_++;
+    subscribers_.push_back(std::make_shared<Subscriber>(Subscriber{id, owner, topic, std::move(callback), nullptr}));
+    return id;
+}
+
+EventBus::Subscription EventBus::subscribeBatch(const std::string &owner, TopicId topic, BatchCallback callback)
+{
+    Subscription id = nextSubscription_++;
+    subscribers_.push_back(std::make_shared<Subscriber>(Subscriber{id, owner, topic, nullptr, std::move(callback)}));
+    return id;
+}
+
+void EventBus::unsubscribe(Subscription subscription)
+{
+    std::erase_if(subscribers_, [subscription](const auto& sub) {
+        if (sub->id != subscription) {
+            return false;
+        }
+        sub->active = false;
+        return true;
+    });
+}
+
+void EventBus::clear()
+{
+    for (auto& sub : subscribers_) {
+        sub->active = false;
+    }
+    subscribers_.clear();
+
+    Event event;
+    while (queue_.tryPop(event)) {
+    }
+}
+
+size_t EventBus::dispatch()
+{
+    batch_.clear();
+    Event event;
+    while (batch_.size() < kQueueCapacity && queue_.tryPop(event)) {
+        batch_.push_back(std::move(event));
+    }
+    if (batch_.empty()) {
+        return 0;
+    }
+
+    // group by topic while keeping publish order inside each topic
+    std::stable_sort(batch_.begin(), batch_.end(),
+        [](const Event& a, const Event& b) { return a.topic < b.topic; });
+
+    // callbacks may (un)subscribe, so deliver to a snapshot of the subscriber list;
+    // removed subscribers are deactivated and skipped
+    dispatchSubscribers_.assign(subscribers_.begin(), subscribers_.end());
+
+    for (size_t begin = 0; begin < batch_.size();) {
+        TopicId topic = batch_[begin].topic;
+        size_t end = begin;
+        payloads_.clear();
+        while (end < batch_.size() && batch_[end].topic == topic) {
+            payloads_.push_back(batch_[end].payload);
+            end++;
+        }
+
+        for (const auto& sub : dispatchSubscribers_) {
+            if (sub->topic != topic || !sub->active) {
+                continue;
+            }
+            if (sub->batchCallback) {
+                sub->batchCallback(payloads_);
+            } else {
+                for (const auto& payload : payloads_) {
+                    if (sub->active) {
+                        sub->callback(payload);
+                    }
+                }
+            }
+        }
+        begin = end;
+    }
+
+    size_t delivered = batch_.size();
+    batch_.clear();
+    payloads_.clear();
+    dispatchSubscribers_.clear();
+    return delivered;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE unsigned pluginTopicId(const char* topic)
+{
+    return EventBus::getInstance().topicId(topic);
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE int pluginPublishTopic(unsigned topicId, const void* data, size_t size)
+{
+    return EventBus::getInstance().publish(topicId, SharedBuffer::copyOf(data, size)) ? 1 : 0;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE int pluginPublish(const char* topic, const void* data, size_t size)
+{
+    return pluginPublishTopic(pluginTopicId(topic), data, size);
+}
@@ -0,0 +1,252 @@
+#include "lib/headless_host.h"
+#include "lib/app_host.h"
+#include "lib/task_pool.h"
+#include "lib/startup_timeline.h"
+#include "lib/metrics.h"
+
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static nlohmann::json Summarize(std::vector<double> samples)
+{
+    if (samples.empty()) {
+        return nlohmann::json::object();
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+    };
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    return {
+        {"meanMs", total / samples.size()},
+        {"p50Ms", percentile(0.50)},
+        {"p95Ms", percentile(0.95)},
+        {"p99Ms", percentile(0.99)},
+        {"maxMs", samples.back()},
+        {"totalMs", total},
+    };
+}
+
+// The whole argument must be a number.
+template <typename T>
+static bool ParseNumber(const char* text, T &value)
+{
+    const char* end = text + std::strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+static int Usage(const char* program, const std::string &problem)
+{
+    std::fprintf(stderr, "%s: %s\n"
+        "usage: %s --headless [--frames <n>] [--fps <hz>] [--workers <n>] [--timeout-ms <ms>]\n"
+        "          [--offline] [--install-all] [--report <file>]\n", program, problem.c_str(), program);
+    return -1;
+}
+
+int HeadlessHost::parseArgs(int argc, char** argv, Options &options)
+{
+    // everything else belongs to the windowed host
+    if (std::none_of(argv + 1, argv + argc, [](const char* arg) { return std::strcmp(arg, "--headless") == 0; })) {
+        return 0;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool takesValue = arg == "--frames" || arg == "--fps" || arg == "--workers" || arg == "--timeout-ms" || arg == "--report";
+        if (takesValue && i + 1 >= argc) {
+            return Usage(argv[0], arg + " needs a value");
+        }
+
+        bool valid = true;
+        if (arg == "--headless") {
+            continue;
+        } else if (arg == "--frames") {
+            valid = ParseNumber(argv[++i], options.frames);
+        } else if (arg == "--fps") {
+            valid = ParseNumber(argv[++i], options.fps) && options.fps > 0.0;
+            options.fps = std::max(options.fps, 1.0);
+        } else if (arg == "--workers") {
+            valid = ParseNumber(argv[++i], options.workers);
+        } else if (arg == "--timeout-ms") {
+            valid = ParseNumber(argv[++i], options.timeoutMs);
+        } else if (arg == "--offline") {
+            options.offline = true;
+        } else if (arg == "--install-all") {
+            options.installAll = true;
+        } else if (arg == "--report") {
+            options.reportPath = argv[++i];
+        } else {
+            HOST_LOG(LogLevel::Warn, "Headless", "Ignoring argument: " + arg);
+        }
+        if (!valid) {
+            return Usage(argv[0], "invalid value for " + arg + ": " + argv[i]);
+        }
+    }
+    return 1;
+}
+
+HeadlessHost::HeadlessHost(const Options &options)
+    : m_options(options)
+{
+    Logger::getInstance().start();
+    Metrics::getInstance().start();
+}
+
+template <typename Done>
+bool HeadlessHost::pumpUntil(Done done)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(m_options.timeoutMs);
+    while (!done()) {
+        if (Clock::now() >= deadline) {
+            return false;
+        }
+        TaskPool::getInstance().drainMainThread();
+        Logger::getInstance().pump();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void HeadlessHost::loadPlugins()
+{
+    auto& manager = PluginManager::getInstance();
+    if (!m_options.offline) {
+        manager.fetchPluginList();
+        if (!pumpUntil([&manager] { return !manager.catalogPending(); })) {
+            HOST_LOG(LogLevel::Warn, "Headless", "No plugin catalog within timeout, using local plugins only");
+        }
+    }
+
+    manager.loadPreDownloadedPlugins();
+
+    if (m_options.installAll) {
+        for (auto& plugin : manager.getPluginList()) {
+            if (!plugin.loaded) {
+                manager.downloadAndLoadPlugin(plugin);
+            }
+        }
+        bool installed = pumpUntil([&manager] { return manager.pendingInstalls() == 0; });
+        if (!installed) {
+            HOST_LOG(LogLevel::Warn, "Headless", "Not every catalog plugin was installed within timeout");
+        }
+    }
+}
+
+int HeadlessHost::run()
+{
+    HOST_LOG(LogLevel::Info, "Headless", "Starting headless host: " + std::to_string(m_options.frames)
+        + " frame(s) at " + std::to_string(m_options.fps) + " fps");
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1280, 720);
+    io.IniFilename = nullptr;
+    io.Fonts->Build();
+
+    TaskPool::getInstance().start(m_options.workers);
+
+    auto loadStart = Clock::now();
+    loadPlugins();
+    double loadMs = ElapsedMs(loadStart, Clock::now());
+
+    Scheduler::getInstance().setProfiling(true);
+
+    std::vector<double> updateMs, guiMs, renderMs, frameMs;
+    updateMs.reserve(m_options.frames);
+    guiMs.reserve(m_options.frames);
+    renderMs.reserve(m_options.frames);
+    frameMs.reserve(m_options.frames);
+    uint64_t vertices = 0;
+
+    const double dt = 1.0 / m_options.fps;
+    auto runStart = Clock::now();
+    for (uint64_t frame = 0; frame < m_options.frames; frame++) {
+        auto t0 = Clock::now();
+        AppHost::UpdatePlugins(frame * dt);
+
+        auto t1 = Clock::now();
+        io.DeltaTime = static_cast<float>(dt);
+        ImGui::NewFrame();
+        AppHost::ShowPluginWindows();
+
+        auto t2 = Clock::now();
+        ImGui::Render();
+        vertices += ImGui::GetDrawData()->TotalVtxCount;
+
+        auto t3 = Clock::now();
+        updateMs.push_back(ElapsedMs(t0, t1));
+        guiMs.push_back(ElapsedMs(t1, t2));
+        renderMs.push_back(ElapsedMs(t2, t3));
+        frameMs.push_back(ElapsedMs(t0, t3));
+
+        if (StartupTimeline::getInstance().frameRendered("headless", PluginManager::getInstance().pendingInstalls() == 0)) {
+            break;
+        }
+    }
+    double wallMs = ElapsedMs(runStart, Clock::now());
+    uint64_t frames = frameMs.size();
+
+    nlohmann::json report;
+    report["frames"] = frames;
+    report["fps"] = m_options.fps;
+    report["simulatedSeconds"] = frames * dt;
+    report["wallMs"] = wallMs;
+    report["pluginLoadMs"] = loadMs;
+    report["averageVertices"] = frames ? vertices / frames : 0;
+    report["phases"] = {
+        {"update", Summarize(updateMs)},
+        {"gui", Summarize(guiMs)},
+        {"render", Summarize(renderMs)},
+        {"frame", Summarize(frameMs)},
+    };
+
+    report["plugins"] = nlohmann::json::array();
+    for (const auto& plugin : PluginManager::getInstance().getPluginList()) {
+        report["plugins"].push_back({{"name", plugin.name}, {"loaded", plugin.loaded}, {"execution", plugin.execution}});
+    }
+    report["owners"] = nlohmann::json::array();
+    for (const auto& cost : Scheduler::getInstance().ownerCosts()) {
+        report["owners"].push_back({{"owner", cost.owner}, {"ticks", cost.ticks}, {"tickMs", cost.tickMs}, {"drawMs", cost.drawMs}});
+    }
+
+    HOST_LOG(LogLevel::Info, "Headless", "Ran " + std::to_string(frames) + " frame(s) in "
+        + std::to_string(wallMs) + " ms, p95 frame " + std::to_string(report["phases"]["frame"].value("p95Ms", 0.0)) + " ms");
+
+    if (!m_options.reportPath.empty()) {
+        std::ofstream out(m_options.reportPath, std::ios::trunc);
+        if (out << report.dump(2) << '\n') {
+            HOST_LOG(LogLevel::Info, "Headless", "Wrote frame report to " + m_options.reportPath);
+        } else {
+            HOST_LOG(LogLevel::Error, "Headless", "Could not write frame report to " + m_options.reportPath);
+        }
+    }
+
+    TaskPool::getInstance().stop();
+    PluginManager::getInstance().unloadAll();
+    ImGui::DestroyContext();
+    Metrics::getInstance().stop();
+    Logger::getInstance().stop();
+
+    return EXIT_SUCCESS;
+}
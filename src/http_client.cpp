@@ -0,0 +1,48 @@
+#include "lib/http_client.h"
+#include "lib/plugin_digest.h"
+
+struct HttpSink {
+    std::string* response;
+    const HttpOptions* options;
+};
+
+CURLcode httpGet(const std::string &url, std::string &response, const HttpOptions &options)
+{
+    // curl's global state must be set up once before any worker uses it
+    static const bool curlInitialized = curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK;
+    (void)curlInitialized;
+
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return CURLE_FAILED_INIT;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    HttpSink sink{&response, &options};
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
+      +[](char* ptr, size_t size, size_t nmemb, void* userdata)->size_t {
+         auto* sink = (HttpSink*)userdata;
+         sink->response->append(ptr, size * nmemb);
+         if (sink->options->digest) {
+             sink->options->digest->update(ptr, size * nmemb);
+         }
+         return size * nmemb;
+      });
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+
+    if (options.maxBytesPerSecond > 0) {
+        curl_easy_setopt(curl, CURLOPT_MAX_RECV_SPEED_LARGE, options.maxBytesPerSecond);
+    }
+    if (options.cancel) {
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, options.cancel);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION,
+          +[](void* cancel, curl_off_t, curl_off_t, curl_off_t, curl_off_t)->int {
+             return static_cast<const std::atomic<bool>*>(cancel)->load(std::memory_order_relaxed) ? 1 : 0;
+          });
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    return res;
+}
@@ -0,0 +1,215 @@
+#include "lib/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef EMSCRIPTEN
+#include <emscripten.h>
+#endif
+
+#if !defined(EMSCRIPTEN) || defined(__EMSCRIPTEN_PTHREADS__)
+#define LOGGER_THREADED 1
+#else
+#define LOGGER_THREADED 0
+#endif
+
+static uint64_t LogClockMs()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+static constexpr std::string_view TRUNCATION_MARKER = "\xE2\x80\xA6"; // U+2026
+
+template <size_t N>
+static void CopyTruncated(char (&dest)[N], std::string_view src)
+{
+    static_assert(N > TRUNCATION_MARKER.size());
+    if (src.size() < N) {
+        std::memcpy(dest, src.data(), src.size());
+        dest[src.size()] = '\0';
+        return;
+    }
+
+    size_t len = N - 1 - TRUNCATION_MARKER.size();
+    // don't split a UTF-8 sequence
+    while (len > 0 && (static_cast<unsigned char>(src[len]) & 0xC0) == 0x80) {
+        len--;
+    }
+    std::memcpy(dest, src.data(), len);
+    std::memcpy(dest + len, TRUNCATION_MARKER.data(), TRUNCATION_MARKER.size());
+    dest[len + TRUNCATION_MARKER.size()] = '\0';
+}
+
+const char* logLevelName(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warn: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    }
+    return "?";
+}
+
+Logger& Logger::getInstance() {
+    static Logger instance;
+    return instance;
+}
+
+Logger::~Logger()
+{
+    stop();
+}
+
+void Logger::start(const std::string &filePath)
+{
+    std::string path = filePath;
+    if (path.empty() && std::getenv("PLUGIN_LOG_FILE")) {
+        path = std::getenv("PLUGIN_LOG_FILE");
+    }
+    if (!path.empty()) {
+        file_.open(path, std::ios::out | std::ios::app);
+    }
+
+#if LOGGER_THREADED
+    if (!running_.exchange(true)) {
+        sinkThread_ = std::thread([this] { sinkLoop(); });
+    }
+#endif
+}
+
+void Logger::stop()
+{
+    if (running_.exchange(false) && sinkThread_.joinable()) {
+        wakeSink();
+        sinkThread_.join();
+    }
+    drain();
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void Logger::write(LogLevel level, std::string_view tag, std::string_view message)
+{
+    LogRecord record;
+    record.level = level;
+    record.timestampMs = LogClockMs();
+    CopyTruncated(record.tag, tag);
+    CopyTruncated(record.message, message);
+
+    if (!queue_.tryPush(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // pairs with the fence in sinkLoop: either the sink sees the record or we see it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sinkWaiting_.load(std::memory_order_relaxed)) {
+        wakeSink();
+    }
+}
+
+void Logger::wakeSink()
+{
+    wakeups_.fetch_add(1, std::memory_order_release);
+    wakeups_.notify_one();
+}
+
+void Logger::pump()
+{
+    if (!running_.load(std::memory_order_relaxed)) {
+        drain();
+    }
+}
+
+void Logger::setForwarder(std::function<void(const LogRecord&)> forwarder)
+{
+    std::lock_guard<std::mutex> drainLock(drainMutex_);
+    forwarder_ = std::move(forwarder);
+}
+
+void Logger::clearHistory()
+{
+    std::lock_guard<std::mutex> lock(historyMutex_);
+    history_.clear();
+}
+
+uint64_t Logger::droppedCount() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void Logger::drain()
+{
+    std::lock_guard<std::mutex> drainLock(drainMutex_);
+
+    LogRecord record;
+    bool wrote = false;
+    while (queue_.tryPop(record)) {
+        if (forwarder_) {
+            forwarder_(record);
+            continue;
+        }
+
+        char line[320];
+        std::snprintf(line, sizeof(line), "[%8.3f][%s][%s] %s\n",
+            record.timestampMs / 1000.0, logLevelName(record.level), record.tag, record.message);
+
+        std::fputs(line, record.level >= LogLevel::Warn ? stderr : stdout);
+        if (file_.is_open()) {
+            file_ << line;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(historyMutex_);
+            if (history_.size() >= kHistorySize) {
+                history_.pop_front();
+            }
+            history_.push_back(record);
+        }
+        wrote = true;
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped_) {
+        std::fprintf(stderr, "[Logger] dropped %llu record(s), log ring was full\n",
+            static_cast<unsigned long long>(dropped - reportedDropped_));
+        reportedDropped_ = dropped;
+    }
+
+    if (wrote) {
+        std::fflush(stdout);
+        if (file_.is_open()) {
+            file_.flush();
+        }
+    }
+}
+
+void Logger::sinkLoop()
+{
+    while (running_.load(std::memory_order_relaxed)) {
+        drain();
+
+        uint32_t seen = wakeups_.load(std::memory_order_acquire);
+        sinkWaiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue_.empty() && running_.load(std::memory_order_relaxed)) {
+            wakeups_.wait(seen, std::memory_order_acquire);
+        }
+        sinkWaiting_.store(false, std::memory_order_relaxed);
+    }
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void pluginLog(int level, const char* tag, const char* message)
+{
+    int clamped = std::clamp(level, PLUGIN_LOG_LEVEL_TRACE, PLUGIN_LOG_LEVEL_ERROR);
+    Logger::getInstance().write(static_cast<LogLevel>(clamped), tag ? tag : "plugin", message ? message : "");
+}
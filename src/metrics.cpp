@@ -0,0 +1,427 @@
+#include "lib/metrics.h"
+#include "lib/logger.h"
+#include "lib/plugin_api.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+
+#if !defined(EMSCRIPTEN) && !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define METRICS_ENDPOINT 1
+#else
+#define METRICS_ENDPOINT 0
+#endif
+
+#if !defined(EMSCRIPTEN) || defined(__EMSCRIPTEN_PTHREADS__)
+#define METRICS_THREADED 1
+#else
+#define METRICS_THREADED 0
+#endif
+
+// how long the exporter thread sleeps at most, so stop() returns promptly
+static constexpr int EXPORT_POLL_MS = 100;
+
+static void AtomicAdd(std::atomic<double> &target, double value)
+{
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+static bool ValidName(const std::string &name)
+{
+    if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+        return false;
+    }
+    for (char c : name) {
+        bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string FormatValue(double value)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.15g", value);
+    return text;
+}
+
+static const char* TypeName(MetricType type)
+{
+    switch (type) {
+    case MetricType::Counter: return "counter";
+    case MetricType::Gauge: return "gauge";
+    case MetricType::Histogram: return "histogram";
+    }
+    return "untyped";
+}
+
+Metric::Metric(MetricType type, const std::vector<double> &bounds)
+    : type_(type)
+    , bounds_(bounds)
+    , buckets_(new std::atomic<uint64_t>[bounds.size() + 1])
+{
+    for (size_t i = 0; i <= bounds_.size(); i++) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Metric::add(double value)
+{
+    if (type_ == MetricType::Counter && value < 0.0) {
+        return;
+    }
+    AtomicAdd(value_, value);
+}
+
+void Metric::set(double value)
+{
+    if (type_ == MetricType::Gauge) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+}
+
+void Metric::observe(double value)
+{
+    if (type_ != MetricType::Histogram) {
+        return;
+    }
+    size_t bucket = 0;
+    while (bucket < bounds_.size() && value > bounds_[bucket]) {
+        bucket++;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    AtomicAdd(value_, value);
+}
+
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::~Metrics()
+{
+    stop();
+}
+
+std::string Metrics::label(const std::string &key, const std::string &value)
+{
+    std::string text = key + "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            text += '\\';
+            text += c;
+        } else if (c == '\n') {
+            text += "\\n";
+        } else {
+            text += c;
+        }
+    }
+    return text + "\"";
+}
+
+const std::vector<double>& Metrics::durationBuckets()
+{
+    static const std::vector<double> buckets = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0,
+    };
+    return buckets;
+}
+
+Metric* Metrics::counter(const std::string &name, const std::string &help, const std::string &labels)
+{
+    return series(name, MetricType::Counter, help, {}, labels);
+}
+
+Metric* Metrics::gauge(const std::string &name, const std::string &help, const std::string &labels)
+{
+    return series(name, MetricType::Gauge, help, {}, labels);
+}
+
+Metric* Metrics::histogram(const std::string &name, const std::string &help, const std::vector<double> &bounds,
+                           const std::string &labels)
+{
+    return series(name, MetricType::Histogram, help, bounds, labels);
+}
+
+Metric* Metrics::series(const std::string &name, MetricType type, const std::string &help,
+                        const std::vector<double> &bounds, const std::string &labels)
+{
+    if (!ValidName(name)) {
+        HOST_LOG(LogLevel::Error, "Metrics", "Invalid metric name: " + name);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, created] = families_.try_emplace(name);
+    Family& family = it->second;
+    if (created) {
+        family.type = type;
+        family.help = help;
+        family.bounds = bounds;
+        std::sort(family.bounds.begin(), family.bounds.end());
+    } else if (family.type != type) {
+        HOST_LOG(LogLevel::Error, "Metrics", "Metric " + name + " is already registered as a " + TypeName(family.type));
+        return nullptr;
+    }
+
+    auto& metric = family.series[labels];
+    if (!metric) {
+        // every series of a histogram shares the buckets of the first registration
+        metric = std::make_unique<Metric>(type, family.bounds);
+    }
+    return metric.get();
+}
+
+std::string Metrics::renderPrometheus() const
+{
+    std::string text;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, family] : families_) {
+        if (!family.help.empty()) {
+            text += "# HELP " + name + " " + family.help + "\n";
+        }
+        text += "# TYPE " + name + " " + TypeName(family.type) + "\n";
+
+        for (const auto& [labels, metric] : family.series) {
+            if (family.type != MetricType::Histogram) {
+                text += name + (labels.empty() ? "" : "{" + labels + "}") + " " + FormatValue(metric->value()) + "\n";
+                continue;
+            }
+
+            std::string prefix = labels.empty() ? "" : labels + ",";
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i <= family.bounds.size(); i++) {
+                cumulative += metric->bucketCount(i);
+                std::string le = i < family.bounds.size() ? FormatValue(family.bounds[i]) : "+Inf";
+                text += name + "_bucket{" + prefix + "le=\"" + le + "\"} " + std::to_string(cumulative) + "\n";
+            }
+            std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+            text += name + "_sum" + suffix + " " + FormatValue(metric->value()) + "\n";
+            text += name + "_count" + suffix + " " + std::to_string(cumulative) + "\n";
+        }
+    }
+    return text;
+}
+
+bool Metrics::start()
+{
+    if (const char* path = std::getenv("PLUGIN_METRICS_FILE")) {
+        filePath_ = path;
+    }
+    if (const char* interval = std::getenv("PLUGIN_METRICS_INTERVAL_MS")) {
+        interval_ = std::chrono::milliseconds(std::max(100L, std::atol(interval)));
+    }
+#if METRICS_ENDPOINT
+    if (const char* port = std::getenv("PLUGIN_METRICS_PORT")) {
+        port_ = std::atoi(port);
+    }
+#endif
+    if (!exporting()) {
+        return false;
+    }
+
+    nextWrite_ = std::chrono::steady_clock::now() + interval_;
+#if METRICS_THREADED
+    if (!running_.exchange(true)) {
+        exportThread_ = std::thread([this] { exportLoop(); });
+    }
+#endif
+    return true;
+}
+
+void Metrics::stop()
+{
+    if (running_.exchange(false) && exportThread_.joinable()) {
+        exportThread_.join();
+    }
+    // a last snapshot, so short runs still leave a file behind
+    if (!filePath_.empty()) {
+        writeFile();
+    }
+}
+
+void Metrics::pump()
+{
+    if (filePath_.empty() || running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= nextWrite_) {
+        nextWrite_ = now + interval_;
+        writeFile();
+    }
+}
+
+// written next to the target and renamed, so collectors never read a partial file
+bool Metrics::writeFile()
+{
+    std::string tempPath = filePath_ + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        if (!(out << renderPrometheus())) {
+            HOST_LOG(LogLevel::Error, "Metrics", "Could not write metrics to " + tempPath);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, filePath_, ec);
+    if (ec) {
+        HOST_LOG(LogLevel::Error, "Metrics", "Could not replace " + filePath_ + ": " + ec.message());
+        return false;
+    }
+    return true;
+}
+
+#if METRICS_ENDPOINT
+static int ListenLocal(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// one short-lived connection per scrape; the scraper is the only client
+static void ServeScrape(int listenFd, const Metrics &metrics)
+{
+    int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[1024];
+    ssize_t received = recv(fd, request, sizeof(request) - 1, 0);
+    std::string line = received > 0 ? std::string(request, received) : "";
+    line = line.substr(0, line.find('\r'));
+
+    std::string status = "200 OK";
+    std::string body;
+    if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET / ", 0) == 0) {
+        body = metrics.renderPrometheus();
+    } else {
+        status = "404 Not Found";
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+    for (size_t sent = 0; sent < response.size();) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    close(fd);
+}
+#endif
+
+void Metrics::exportLoop()
+{
+#if METRICS_ENDPOINT
+    int listenFd = -1;
+    if (port_ > 0) {
+        listenFd = ListenLocal(port_);
+        if (listenFd < 0) {
+            HOST_LOG(LogLevel::Error, "Metrics", "Could not listen on 127.0.0.1:" + std::to_string(port_));
+        } else {
+            HOST_LOG(LogLevel::Info, "Metrics", "Serving metrics on http://127.0.0.1:" + std::to_string(port_) + "/metrics");
+        }
+    }
+#endif
+
+    while (running_.load(std::memory_order_relaxed)) {
+#if METRICS_ENDPOINT
+        // poll() ignores a negative fd and just sleeps
+        pollfd listener{listenFd, POLLIN, 0};
+        if (poll(&listener, 1, EXPORT_POLL_MS) > 0 && (listener.revents & POLLIN)) {
+            ServeScrape(listenFd, *this);
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(EXPORT_POLL_MS));
+#endif
+        auto now = std::chrono::steady_clock::now();
+        if (!filePath_.empty() && now >= nextWrite_) {
+            nextWrite_ = now + interval_;
+            writeFile();
+        }
+    }
+
+#if METRICS_ENDPOINT
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+#endif
+}
+
+static std::string PluginLabels(const char* owner)
+{
+    return Metrics::label("plugin", owner ? owner : "plugin");
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginMetricCounter(const char* owner, const char* name, const char* help)
+{
+    return Metrics::getInstance().counter(name ? name : "", help ? help : "", PluginLabels(owner));
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginMetricGauge(const char* owner, const char* name, const char* help)
+{
+    return Metrics::getInstance().gauge(name ? name : "", help ? help : "", PluginLabels(owner));
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginMetricHistogram(const char* owner, const char* name, const char* help,
+                                                            const double* bounds, size_t boundCount)
+{
+    std::vector<double> buckets = bounds && boundCount ? std::vector<double>(bounds, bounds + boundCount)
+                                                       : Metrics::durationBuckets();
+    return Metrics::getInstance().histogram(name ? name : "", help ? help : "", buckets, PluginLabels(owner));
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void pluginMetricAdd(void* metric, double value)
+{
+    if (metric) {
+        static_cast<Metric*>(metric)->add(value);
+    }
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void pluginMetricSet(void* metric, double value)
+{
+    if (metric) {
+        static_cast<Metric*>(metric)->set(value);
+    }
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void pluginMetricObserve(void* metric, double value)
+{
+    if (metric) {
+        static_cast<Metric*>(metric)->observe(value);
+    }
+}
@@ -0,0 +1,246 @@
+#include "lib/plugin_allocator.h"
+#include "lib/plugin_api.h"
+
+#include <algorithm>
+#include <limits>
+#include <new>
+
+void AllocationStats::onAllocate(uint64_t bytes)
+{
+    uint64_t inUse = bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (inUse > peak && !peakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+    }
+    liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationStats::onFree(uint64_t bytes, uint64_t count)
+{
+    bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+    liveAllocations.fetch_sub(count, std::memory_order_relaxed);
+}
+
+Arena::Arena(AllocationStats &stats, size_t chunkSize)
+    : stats_(stats), chunkSize_(chunkSize)
+{
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+void* Arena::allocate(size_t size, size_t align)
+{
+    // size and align come straight from plugins through the C API
+    if (align == 0) {
+        align = alignof(std::max_align_t);
+    }
+    if ((align & (align - 1)) != 0 || size > std::numeric_limits<size_t>::max() - align) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (;;) {
+        if (current_ < chunks_.size()) {
+            Chunk& chunk = chunks_[current_];
+            uintptr_t cursor = reinterpret_cast<uintptr_t>(chunk.data.get()) + chunk.used;
+            size_t padding = static_cast<size_t>(-cursor & (align - 1));
+            size_t remaining = chunk.size - chunk.used;
+            if (padding <= remaining && size <= remaining - padding) {
+                chunk.used += padding + size;
+                bytesInUse_ += size;
+                allocations_++;
+                stats_.onAllocate(size);
+                return reinterpret_cast<void*>(cursor + padding);
+            }
+            if (current_ + 1 < chunks_.size()) {
+                current_++;
+                continue;
+            }
+        }
+
+        size_t chunkSize = std::max(chunkSize_, size + align);
+        std::unique_ptr<std::byte[]> data(new (std::nothrow) std::byte[chunkSize]);
+        if (!data) {
+            return nullptr;
+        }
+        chunks_.push_back(Chunk{std::move(data), chunkSize, 0});
+        current_ = chunks_.size() - 1;
+        stats_.bytesReserved.fetch_add(chunkSize, std::memory_order_relaxed);
+    }
+}
+
+void Arena::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& chunk : chunks_) {
+        chunk.used = 0;
+    }
+    current_ = 0;
+    stats_.onFree(bytesInUse_, allocations_);
+    bytesInUse_ = 0;
+    allocations_ = 0;
+}
+
+void Arena::release()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& chunk : chunks_) {
+        stats_.bytesReserved.fetch_sub(chunk.size, std::memory_order_relaxed);
+    }
+    chunks_.clear();
+    current_ = 0;
+    stats_.onFree(bytesInUse_, allocations_);
+    bytesInUse_ = 0;
+    allocations_ = 0;
+}
+
+PoolAllocator::PoolAllocator(AllocationStats &stats, size_t blockSize, size_t blocksPerChunk)
+    : stats_(stats),
+      blockSize_((std::max(blockSize, sizeof(FreeNode)) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1)),
+      blocksPerChunk_(std::max<size_t>(blocksPerChunk, 1))
+{
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.onFree(liveBlocks_ * blockSize_, liveBlocks_);
+    stats_.bytesReserved.fetch_sub(chunks_.size() * blockSize_ * blocksPerChunk_, std::memory_order_relaxed);
+}
+
+void* PoolAllocator::allocate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!freeList_) {
+        size_t chunkBytes = blockSize_ * blocksPerChunk_;
+        chunks_.emplace_back(new std::byte[chunkBytes]);
+        stats_.bytesReserved.fetch_add(chunkBytes, std::memory_order_relaxed);
+
+        std::byte* chunk = chunks_.back().get();
+        for (size_t i = blocksPerChunk_; i-- > 0;) {
+            auto* node = reinterpret_cast<FreeNode*>(chunk + i * blockSize_);
+            node->next = freeList_;
+            freeList_ = node;
+        }
+    }
+
+    FreeNode* node = freeList_;
+    freeList_ = node->next;
+    liveBlocks_++;
+    stats_.onAllocate(blockSize_);
+    return node;
+}
+
+void PoolAllocator::deallocate(void* block)
+{
+    if (!block) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* node = static_cast<FreeNode*>(block);
+    node->next = freeList_;
+    freeList_ = node;
+    liveBlocks_--;
+    stats_.onFree(blockSize_, 1);
+}
+
+AllocatorService& AllocatorService::getInstance() {
+    static AllocatorService instance;
+    return instance;
+}
+
+AllocatorService::PluginHeap& AllocatorService::heap(const std::string &owner)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& heap = heaps_[owner];
+    if (!heap) {
+        heap = std::make_unique<PluginHeap>();
+    }
+    return *heap;
+}
+
+Arena& AllocatorService::arena(const std::string &owner)
+{
+    return heap(owner).arena;
+}
+
+Arena& AllocatorService::frameArena(const std::string &owner)
+{
+    return heap(owner).frameArena;
+}
+
+PoolAllocator& AllocatorService::createPool(const std::string &owner, size_t blockSize, size_t blocksPerChunk)
+{
+    PluginHeap& pluginHeap = heap(owner);
+    std::lock_guard<std::mutex> lock(mutex_);
+    pluginHeap.pools.push_back(std::make_unique<PoolAllocator>(pluginHeap.stats, blockSize, blocksPerChunk));
+    return *pluginHeap.pools.back();
+}
+
+void AllocatorService::beginFrame()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [owner, heap] : heaps_) {
+        heap->frameArena.reset();
+    }
+}
+
+void AllocatorService::releaseOwner(const std::string &owner)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    heaps_.erase(owner);
+}
+
+void AllocatorService::releaseAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    heaps_.clear();
+}
+
+std::vector<AllocatorService::Usage> AllocatorService::usage() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Usage> result;
+    result.reserve(heaps_.size());
+    for (const auto& [owner, heap] : heaps_) {
+        const auto& stats = heap->stats;
+        result.push_back(Usage{
+            owner,
+            stats.bytesInUse.load(std::memory_order_relaxed),
+            stats.peakBytes.load(std::memory_order_relaxed),
+            stats.bytesReserved.load(std::memory_order_relaxed),
+            stats.liveAllocations.load(std::memory_order_relaxed),
+            stats.totalAllocations.load(std::memory_order_relaxed),
+        });
+    }
+    return result;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginArenaAlloc(const char* owner, size_t size, size_t align)
+{
+    return AllocatorService::getInstance().arena(owner).allocate(size, align);
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginFrameAlloc(const char* owner, size_t size, size_t align)
+{
+    return AllocatorService::getInstance().frameArena(owner).allocate(size, align);
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginPoolCreate(const char* owner, size_t blockSize)
+{
+    return &AllocatorService::getInstance().createPool(owner, blockSize);
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void* pluginPoolAlloc(void* pool)
+{
+    return static_cast<PoolAllocator*>(pool)->allocate();
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void pluginPoolFree(void* pool, void* block)
+{
+    static_cast<PoolAllocator*>(pool)->deallocate(block);
+}
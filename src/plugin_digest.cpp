@@ -0,0 +1,159 @@
+#include "lib/plugin_digest.h"
+#include "lib/metrics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// subtrees smaller than this are not worth a thread
+static constexpr size_t PARALLEL_MIN_BYTES = 1 << 20;
+// at most 2^depth threads hash one buffer
+static constexpr int MAX_PARALLEL_DEPTH = 3;
+
+static std::string ToHex(const uint8_t* bytes, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(size * 2);
+    for (size_t i = 0; i < size; i++) {
+        hex += digits[bytes[i] >> 4];
+        hex += digits[bytes[i] & 0xf];
+    }
+    return hex;
+}
+
+PluginDigest PluginDigest::parse(const std::string &text)
+{
+    PluginDigest digest;
+    size_t colon = text.find(':');
+    if (colon == std::string::npos) {
+        digest.hex = text;
+        return digest;
+    }
+
+    std::string algorithm = text.substr(0, colon);
+    digest.hex = text.substr(colon + 1);
+    if (algorithm == "blake3") {
+        digest.algorithm = DigestAlgorithm::Blake3;
+    } else if (algorithm != "sha1") {
+        // unknown algorithms never verify
+        digest.hex.clear();
+    }
+    return digest;
+}
+
+std::string PluginDigest::tagged() const
+{
+    // an unknown or missing digest stays empty, so it is rejected as invalid plugin data
+    if (hex.empty()) {
+        return "";
+    }
+    return std::string(digestAlgorithmName(algorithm)) + ":" + hex;
+}
+
+const char* digestAlgorithmName(DigestAlgorithm algorithm)
+{
+    return algorithm == DigestAlgorithm::Blake3 ? "blake3" : "sha1";
+}
+
+// hash throughput is plugin_hash_bytes_total / plugin_hash_seconds_total, per algorithm
+static void RecordHash(DigestAlgorithm algorithm, size_t size, std::chrono::steady_clock::time_point start)
+{
+    struct HashMetrics {
+        Metric* bytes;
+        Metric* seconds;
+    };
+    static const auto make = [](DigestAlgorithm algorithm) {
+        std::string labels = Metrics::label("algorithm", digestAlgorithmName(algorithm));
+        return HashMetrics{
+            Metrics::getInstance().counter("plugin_hash_bytes_total", "Bytes hashed to verify plugins", labels),
+            Metrics::getInstance().counter("plugin_hash_seconds_total", "Wall time spent hashing plugins", labels),
+        };
+    };
+    static const HashMetrics sha1 = make(DigestAlgorithm::Sha1);
+    static const HashMetrics blake3 = make(DigestAlgorithm::Blake3);
+
+    const HashMetrics& metrics = algorithm == DigestAlgorithm::Blake3 ? blake3 : sha1;
+    metrics.bytes->add(static_cast<double>(size));
+    metrics.seconds->add(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+static unsigned ParallelDepth()
+{
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+    return 0;
+#else
+    unsigned depth = 0;
+    for (unsigned threads = std::thread::hardware_concurrency(); threads > 1 && depth < MAX_PARALLEL_DEPTH; threads /= 2) {
+        depth++;
+    }
+    return depth;
+#endif
+}
+
+// Chaining value of a BLAKE3 subtree; the left half goes to a new thread while
+// the depth budget and the input size allow it.
+static blake3::Output Blake3Subtree(const uint8_t* data, size_t size, uint64_t chunk, unsigned depth)
+{
+    if (depth == 0 || size < 2 * PARALLEL_MIN_BYTES) {
+        return blake3::subtreeOutput(data, size, chunk);
+    }
+
+    size_t leftSize = blake3::leftSubtreeLen(size);
+    uint32_t left[8], right[8];
+    std::thread leftThread([&] {
+        Blake3Subtree(data, leftSize, chunk, depth - 1).chainingValue(left);
+    });
+    Blake3Subtree(data + leftSize, size - leftSize, chunk + leftSize / blake3::CHUNK_LEN, depth - 1).chainingValue(right);
+    leftThread.join();
+    return blake3::parentOutput(left, right);
+}
+
+std::string digestHex(DigestAlgorithm algorithm, const void* data, size_t size)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (algorithm == DigestAlgorithm::Blake3) {
+        uint8_t digest[blake3::OUT_LEN];
+        Blake3Subtree(static_cast<const uint8_t*>(data), size, 0, ParallelDepth()).rootBytes(digest);
+        RecordHash(algorithm, size, start);
+        return ToHex(digest, sizeof(digest));
+    }
+
+    sha1::SHA1 sha;
+    sha.processBytes(data, size);
+    uint8_t digest[20];
+    sha.getDigestBytes(digest);
+    RecordHash(algorithm, size, start);
+    return ToHex(digest, sizeof(digest));
+}
+
+DigestStream::DigestStream(DigestAlgorithm algorithm)
+    : algorithm_(algorithm)
+{
+}
+
+void DigestStream::update(const void* data, size_t size)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (algorithm_ == DigestAlgorithm::Blake3) {
+        blake3_.processBytes(data, size);
+    } else {
+        sha1_.processBytes(data, size);
+    }
+    RecordHash(algorithm_, size, start);
+}
+
+std::string DigestStream::finishHex() const
+{
+    if (algorithm_ == DigestAlgorithm::Blake3) {
+        uint8_t digest[blake3::OUT_LEN];
+        blake3_.getDigestBytes(digest);
+        return ToHex(digest, sizeof(digest));
+    }
+
+    // getDigestBytes pads the state, so finish on a copy
+    sha1::SHA1 sha = sha1_;
+    uint8_t digest[20];
+    sha.getDigestBytes(digest);
+    return ToHex(digest, sizeof(digest));
+}
@@ -5,20 +5,29 @@
 #include <string>
 #include <vector>
 #include <functional>
-#include <iostream>
 #include <fstream>
 #include <cstdio>
 #include <utility>
 #include <filesystem>
 #include <cassert>
+#include <algorithm>
 #include <nlohmann/json.hpp>
 
+#include "lib/plugin_store.h"
+#include "lib/task_pool.h"
+#include "lib/event_bus.h"
+#include "lib/plugin_allocator.h"
+#include "lib/worker_supervisor.h"
+#include "lib/startup_timeline.h"
+#include "lib/metrics.h"
+#include "lib/plugin_updater.h"
 #include "lib/tiny_sha1.hpp"
+#include "lib/plugin_digest.h"
 
 #ifdef EMSCRIPTEN
 #include <emscripten/fetch.h>
 #else
-#include <curl/curl.h>
+#include "lib/http_client.h"
 #endif
 
 #if defined(_WIN32)
@@ -30,7 +39,7 @@
 std::string GetAPIURL() {
     std::string API_URL = "";
     if (!std::getenv("API_URL")) {
-        printf("API_URL not set, using default %s\n", "https://plugins-dev-4cd350c041fa.herokuapp.com/api");
+        PluginManager::log("API_URL not set, using default https://plugins-dev-4cd350c041fa.herokuapp.com/api");
         API_URL = "https://plugins-dev-4cd350c041fa.herokuapp.com/api";
     } else {
         API_URL = std::string(std::getenv("API_URL"));
@@ -48,17 +57,38 @@ static std::string GetPluginBaseUrl() {
 }
 
 #if defined(__APPLE__)
-static const char* PLUGIN_DEST = "~/Library/Application Support/plugin_dev/plugins/";
+static const char* DEFAULT_PLUGIN_DEST = "~/Library/Application Support/plugin_dev/plugins/";
 #elif defined(_WIN32)
-static const char* PLUGIN_DEST = "C:\\Users\\<username>\\AppData\\Roaming\\plugin_dev\\plugins\\";
+static const char* DEFAULT_PLUGIN_DEST = "C:\\Users\\<username>\\AppData\\Roaming\\plugin_dev\\plugins\\";
 #elif defined(EMSCRIPTEN)
-static const char* PLUGIN_DEST = "/plugins/";
+static const char* DEFAULT_PLUGIN_DEST = "/plugins/";
 #elif defined(__linux__)
-static const char* PLUGIN_DEST = "~/.local/share/plugin_dev/plugins/";
+static const char* DEFAULT_PLUGIN_DEST = "~/.local/share/plugin_dev/plugins/";
 #else
 #error "Unknown platform"
 #endif
 
+// PLUGIN_INSTALL_DIR overrides where downloaded plugins live, e.g. to isolate benchmark runs
+static std::string GetPluginDest()
+{
+#ifdef EMSCRIPTEN
+    return DEFAULT_PLUGIN_DEST;
+#else
+    static const std::string dest = [] {
+        const char* dir = std::getenv("PLUGIN_INSTALL_DIR");
+        if (!dir || !*dir) {
+            return std::string(DEFAULT_PLUGIN_DEST);
+        }
+        std::string path = dir;
+        if (path.back() != '/' && path.back() != '\\') {
+            path += '/';
+        }
+        return path;
+    }();
+    return dest;
+#endif
+}
+
 #include <format>
 #include <string>
 #include <cstdint>
@@ -88,23 +118,99 @@ std::string sha1FileHex(const std::string& filePath) {
     return sha1Hash;
 }
 
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// install cache: "hit" when an installed plugin verifies, "stale" when it does not
+// and "miss" for every download
+static void CountInstallCache(const char* result)
+{
+    if (Metric* metric = Metrics::getInstance().counter("plugin_install_cache_total",
+            "Plugin loads served from the install directory (hit) or the registry (miss)", Metrics::label("result", result))) {
+        metric->add(1);
+    }
+}
+
+static void CountDownloaded(size_t bytes)
+{
+    static Metric* downloaded = Metrics::getInstance().counter("plugin_download_bytes_total", "Plugin bytes downloaded from the registry");
+    downloaded->add(static_cast<double>(bytes));
+}
+
+static Metric* LoadedPlugins(const char* execution)
+{
+    return Metrics::getInstance().gauge("plugin_loaded", "Plugins currently loaded", Metrics::label("execution", execution));
+}
+
+std::string PluginManager::catalogUrl()
+{
+    return GetPluginListUrl();
+}
+
+std::string PluginManager::installDir()
+{
+    return GetPluginDest();
+}
+
 PluginManager& PluginManager::getInstance() {
     static PluginManager instance;
-    if (!std::filesystem::exists(PLUGIN_DEST)) {
-        std::filesystem::create_directories(PLUGIN_DEST);
+    if (!std::filesystem::exists(GetPluginDest())) {
+        std::filesystem::create_directories(GetPluginDest());
     }
     return instance;
 }
 
-void PluginManager::log(const std::string& msg)
+void PluginManager::log(const std::string& msg, LogLevel level)
 {
-    std::cout << "[PluginManager] " << msg << std::endl;
+    HOST_LOG(level, "PluginManager", msg);
 }
 
 void PluginManager::registerRenderable(RenderableFunc func)
 {
     renderables_.push_back(std::move(func));
-    log("Registered renderable function.");
+    log("Registered renderable function.", LogLevel::Debug);
+}
+
+LoadablePlugin* PluginManager::findPlugin(const std::string &name)
+{
+    auto it = std::find_if(pluginList_.begin(), pluginList_.end(),
+        [&name](const LoadablePlugin& plugin) { return plugin.name == name; });
+    return it == pluginList_.end() ? nullptr : &*it;
+}
+
+Scheduler::Handle PluginManager::registerTick(double rateHz, TickFunc func)
+{
+    log("Registered " + std::to_string(rateHz) + " Hz tick for " + currentPlugin_, LogLevel::Debug);
+    return Scheduler::getInstance().registerTick(currentPlugin_, rateHz, std::move(func));
+}
+
+Scheduler::Handle PluginManager::registerDraw(const std::string &label, DrawFunc func)
+{
+    log("Registered draw window '" + label + "' for " + currentPlugin_, LogLevel::Debug);
+    return Scheduler::getInstance().registerDraw(currentPlugin_, label, std::move(func));
+}
+
+DrawListComposer::Handle PluginManager::registerPreparedDraw(const std::string &label, PrepareFunc func)
+{
+    log("Registered prepared draw window '" + label + "' for " + currentPlugin_, LogLevel::Debug);
+    return DrawListComposer::getInstance().registerPrepared(currentPlugin_, label, std::move(func));
+}
+
+void PluginManager::requestRedraw()
+{
+    Scheduler::getInstance().requestRedraw();
+}
+
+const std::string& PluginManager::currentPlugin() const
+{
+    return currentPlugin_;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void pluginRequestRedraw()
+{
+    Scheduler::getInstance().requestRedraw();
 }
 
 std::vector<LoadablePlugin>& PluginManager::getPluginList()
@@ -117,33 +223,60 @@ const std::vector<RenderableFunc>& PluginManager::getRenderables() const
     return renderables_;
 }
 
-void PluginManager::parsePluginList(const std::string &jsonData)
+bool PluginManager::parseCatalog(const std::string &jsonData, std::vector<LoadablePlugin> &plugins)
 {
-    pluginList_.clear();
-    
     try {
         auto json = nlohmann::json::parse(jsonData);
-        if (json.is_array()) {
-            for (const auto& item : json) {
-                if (item.is_object()) {
-                    pluginList_.emplace_back(LoadablePlugin{
-                        item.value("name", ""),
-                        item.value("size", 0UL),
-                        item.value("sha1", ""),
-                        item.value("version", "")
-                    });
+        if (!json.is_array()) {
+            log("Invalid JSON format: expected an array.", LogLevel::Error);
+            return false;
+        }
+        for (const auto& item : json) {
+            if (item.is_object()) {
+                // older registries only send a bare "sha1"
+                std::string text = item.value("digest", item.value("sha1", ""));
+                PluginDigest digest = PluginDigest::parse(text);
+                if (digest.empty() && !text.empty()) {
+                    // the plain sha1 still verifies when the tagged digest uses an algorithm we lack
+                    digest = PluginDigest::parse(item.value("sha1", ""));
+                    if (digest.empty()) {
+                        log("Unsupported digest algorithm for " + item.value("name", "") + ": " + text, LogLevel::Error);
+                    }
                 }
+                LoadablePlugin plugin{
+                    item.value("name", ""),
+                    item.value("size", 0UL),
+                    digest.tagged(),
+                    item.value("version", "")
+                };
+                plugin.execution = item.value("execution", "in-process");
+                plugins.push_back(std::move(plugin));
             }
-        } else {
-            log("Invalid JSON format: expected an array.");
-            return;
         }
     } catch (const nlohmann::json::parse_error& e) {
-        log("JSON parse error: " + std::string(e.what()));
+        log("JSON parse error: " + std::string(e.what()), LogLevel::Error);
+        return false;
+    }
+    return true;
+}
+
+void PluginManager::parsePluginList(const std::string &jsonData)
+{
+    bool fetched = catalogPending_;
+    catalogPending_ = false;
+    pluginList_.clear();
+
+    if (!parseCatalog(jsonData, pluginList_)) {
         return;
     }
     
     log("Parsed plugin list: " + std::to_string(pluginList_.size()) + " plugin(s).");
+    StartupTimeline::getInstance().mark("catalog_received");
+    if (fetched) {
+        static Metric* latency = Metrics::getInstance().histogram("plugin_catalog_fetch_seconds",
+            "Time from requesting the plugin catalog to parsing it", Metrics::durationBuckets());
+        latency->observe(SecondsSince(catalogRequested_));
+    }
 }
 
 #ifdef EMSCRIPTEN
@@ -162,13 +295,17 @@ static void onFetchListSuccess(emscripten_fetch_t *fetch)
 static void onFetchListFailed(emscripten_fetch_t *fetch)
 {
     auto *manager = reinterpret_cast<PluginManager*>(fetch->userData);
-    manager->log("Fetch plugin list failed, status=" + std::to_string(fetch->status));
+    manager->log("Fetch plugin list failed, status=" + std::to_string(fetch->status), LogLevel::Error);
     emscripten_fetch_close(fetch);
+    manager->catalogFetchFailed();
 }
 
 void PluginManager::fetchPluginList()
 {
     log("Fetching plugin list (Emscripten)...");
+    catalogPending_ = true;
+    catalogRequested_ = std::chrono::steady_clock::now();
+    StartupTimeline::getInstance().mark("catalog_requested");
     emscripten_fetch_attr_t attr;
     emscripten_fetch_attr_init(&attr);
     attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
@@ -182,30 +319,19 @@ void PluginManager::fetchPluginList()
 void PluginManager::fetchPluginList()
 {
     log("Fetching plugin list (Native)...");
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        log("Curl init failed. Cannot fetch plugin list.");
-        return;
-    }
-    std::string response;
-    curl_easy_setopt(curl, CURLOPT_URL, GetPluginListUrl().c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
-      +[](char* ptr, size_t size, size_t nmemb, void* userdata)->size_t {
-         auto* resp = (std::string*)userdata;
-         resp->append(ptr, size * nmemb);
-         return size * nmemb;
-      });
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) {
-        log(std::string("Plugin list fetch failed: ") + curl_easy_strerror(res));
-        return;
-    }
+    catalogPending_ = true;
+    catalogRequested_ = std::chrono::steady_clock::now();
+    StartupTimeline::getInstance().mark("catalog_requested");
+    TaskPool::getInstance().submit([this]() -> TaskPool::Task {
+        std::string response;
+        CURLcode res = httpGet(GetPluginListUrl(), response);
+        if (res != CURLE_OK) {
+            log(std::string("Plugin list fetch failed: ") + curl_easy_strerror(res), LogLevel::Error);
+            return [this]() { catalogFetchFailed(); };
+        }
 
-    parsePluginList(response);
+        return [this, response]() { parsePluginList(response); };
+    });
 }
 #endif // EMSCRIPTEN
 
@@ -274,11 +400,20 @@ typedef struct {
 
 
 void PluginManager::loadPreDownloadedPlugins() {
-    // scan for downloaded pluings in PLUGIN_DEST and load them
+    // scan for downloaded pluings in the install directory and load them
     auto& pluginList = getPluginList();
-    printf("Checking for pre-downloaded plugins in %s\n", PLUGIN_DEST);
-    for (const auto& entry : std::filesystem::directory_iterator(PLUGIN_DEST)) {
-        printf("Found file: %s\n", entry.path().string().c_str());
+    const std::string dest = GetPluginDest();
+    log("Checking for pre-downloaded plugins in " + dest);
+    double scanStart = StartupTimeline::getInstance().nowMs();
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dest, ec)) {
+        log("No plugin directory yet", LogLevel::Debug);
+        return;
+    }
+    // updates prefetched during the last session replace the installed files before anything is loaded
+    PluginUpdater::getInstance().applyStaged();
+    for (const auto& entry : std::filesystem::directory_iterator(dest)) {
+        log("Found file: " + entry.path().string(), LogLevel::Debug);
         if (entry.is_regular_file()) {
             // find the plugin in the plugin list
             auto it = std::find_if(pluginList.begin(), pluginList.end(),
@@ -290,7 +425,7 @@ void PluginManager::loadPreDownloadedPlugins() {
                 // TODO: validate sha with server if we have connection
                 std::string pluginPath = entry.path().string();
                 log("Loading pre-downloaded plugin: " + pluginPath);
-                loadPluginFromFile(pluginPath);
+                startPlugin(pluginPath, "", "");
             } else {
                 // we should validate
                 it->downloadedPath = entry.path().string();
@@ -299,6 +434,20 @@ void PluginManager::loadPreDownloadedPlugins() {
         }
     }
 
+    StartupTimeline::getInstance().record("local_plugins", scanStart, StartupTimeline::getInstance().nowMs());
+}
+
+void PluginManager::catalogFetchFailed()
+{
+    catalogPending_ = false;
+    StartupTimeline::getInstance().mark("catalog_failed");
+    static Metric* failures = Metrics::getInstance().counter("plugin_catalog_fetch_failures_total", "Plugin catalog fetches that failed");
+    failures->add(1);
+}
+
+void PluginManager::installFinished()
+{
+    pendingInstalls_ = std::max(pendingInstalls_ - 1, 0);
 }
 
 #ifdef EMSCRIPTEN
@@ -306,99 +455,55 @@ void PluginManager::loadPreDownloadedPlugins() {
 struct DownloadCtx {
     std::string localPath;
     PluginManager* manager;
-    LoadablePlugin* plugin;
+    LoadablePlugin plugin;
+    double startMs;
 };
 
-static void onPluginFetchSuccess(emscripten_fetch_t *fetch)
-{
+static void fetchPluginSuccess(emscripten_fetch_t *fetch) {
     auto* ctx = reinterpret_cast<DownloadCtx*>(fetch->userData);
-    PluginManager* manager = ctx->manager;
-    auto& plugin = *ctx->plugin;
-
-    FILE* fp = std::fopen(ctx->localPath.c_str(), "wb");
-    if (fp) {
-        fwrite(fetch->data, 1, fetch->numBytes, fp);
-        fclose(fp);
-        plugin.downloadedPath = ctx->localPath;
-        manager->loadPlugin(plugin);
-    } else {
-        manager->log("Could not create file: " + ctx->localPath);
-    }
+    ctx->manager->log("Plugin fetch success: " + ctx->plugin.name);
+    auto& timeline = StartupTimeline::getInstance();
+    timeline.record("download:" + ctx->plugin.name, ctx->startMs, timeline.nowMs());
+    CountDownloaded(fetch->numBytes);
+
+    // hash on a worker; the fetch buffer stays alive until the continuation closes it
+    TaskPool::getInstance().submit([fetch, ctx]() -> TaskPool::Task {
+        bool verified = ctx->manager->verifyPlugin(ctx->plugin, fetch->data, fetch->numBytes);
+
+        return [fetch, ctx, verified]() {
+            bool installed = false;
+            if (verified) {
+                if (auto* plugin = ctx->manager->findPlugin(ctx->plugin.name)) {
+                    installed = ctx->manager->installPlugin(*plugin, ctx->localPath, fetch->data, fetch->numBytes) >= 0;
+                }
+            }
+            PluginStore::FlushCallback onPersisted;
+            if (installed) {
+                onPersisted = [name = ctx->plugin.name](bool ok) {
+                    if (!ok) {
+                        PluginManager::log("Could not persist " + name + " to IndexedDB, it is downloaded again on the next visit",
+                                           LogLevel::Warn);
+                    }
+                };
+            }
+            PluginStore::getInstance().endBatch(std::move(onPersisted));
+            ctx->manager->installFinished();
 
-    emscripten_fetch_close(fetch);
-    delete ctx;
+            emscripten_fetch_close(fetch);
+            delete ctx;
+        };
+    });
 }
 
-static void onPluginFetchFailed(emscripten_fetch_t *fetch)
-{
+static void fetchPluginFail(emscripten_fetch_t *fetch) {
     auto* ctx = reinterpret_cast<DownloadCtx*>(fetch->userData);
-    std::cout << "Plugin fetch failed, status=" + std::to_string(fetch->status) << std::endl;
-    delete ctx;
-    emscripten_fetch_close(fetch);
-}
+    ctx->manager->log("Plugin fetch failed, status=" + std::to_string(fetch->status), LogLevel::Error);
+    PluginStore::getInstance().endBatch();
+    ctx->manager->installFinished();
 
-namespace idb {
-static void success(emscripten_fetch_t *fetch) {
-    printf("IDB store succeeded.\n");
-    emscripten_fetch_close(fetch);
-  }
-  
-  static void failure(emscripten_fetch_t *fetch) {
-    printf("IDB store failed.\n");
-    emscripten_fetch_close(fetch);
-  }
-  
-  static void persistFileToIndexedDB(const char *outputFilename, uint8_t *data, size_t numBytes) {
-    emscripten_fetch_attr_t attr;
-    emscripten_fetch_attr_init(&attr);
-    strcpy(attr.requestMethod, "EM_IDB_STORE");
-    attr.attributes = EMSCRIPTEN_FETCH_REPLACE | EMSCRIPTEN_FETCH_PERSIST_FILE;
-    attr.requestData = (char *)data;
-    attr.requestDataSize = numBytes;
-    attr.onsuccess = success;
-    attr.onerror = failure;
-    emscripten_fetch(&attr, outputFilename);
-  }
-}
-
-static void fetchPluginSuccess(emscripten_fetch_t *fetch) {
-    auto* ctx = reinterpret_cast<DownloadCtx*>(fetch->userData);
-  
-    FILE *fp = fopen(ctx->localPath.c_str(), "wb");
-    if (fp) {
-      fwrite(fetch->data, 1, fetch->numBytes, fp);
-      fclose(fp);
-        idb::persistFileToIndexedDB(ctx->localPath.c_str(), (uint8_t *)fetch->data, fetch->numBytes);
-        // sync
-        EM_ASM({
-            FS.syncfs(false, function(err) {
-                assert(!err);
-                Module.print("end file sync..");
-                Module.syncdone = 1;
-            });
-        });
-
-        std::cout << "[Web] Plugin fetch success, writing to file: " << ctx->localPath << "\n";
-        auto& plugin = *ctx->plugin;
-        plugin.downloadedPath = "/plugins/" + plugin.name;
-        ctx->manager->loadPlugin(plugin);
-    } else {
-      std::cerr << "[Web] Could not create file: " << ctx->localPath << "\n";
-    }
-  
     emscripten_fetch_close(fetch);
     delete ctx;
-  }
-  
-  static void fetchPluginFail(emscripten_fetch_t *fetch) {
-    std::cerr << "[Web] Plugin fetch failed, status=" << fetch->status << "\n";
-    struct DownloadCtx {
-      std::string localPath;
-    };
-    auto *ctx = (DownloadCtx *)fetch->userData;
-    delete ctx;
-    emscripten_fetch_close(fetch);
-  }
+}
 
 void PluginManager::downloadAndLoadPlugin(LoadablePlugin &plugin)
 {
@@ -408,10 +513,16 @@ void PluginManager::downloadAndLoadPlugin(LoadablePlugin &plugin)
     ctx->manager = this;
 
     std::string url = GetPluginBaseUrl() + plugin.name;
-    std::string localPath = PLUGIN_DEST + plugin.name;
-    std::cout << "Downloading plugin from: " + url + " to " + localPath << std::endl;
+    std::string localPath = GetPluginDest() + plugin.name;
+    log("Downloading plugin from: " + url + " to " + localPath);
     ctx->localPath = localPath;
-    ctx->plugin = &plugin;
+    ctx->plugin = plugin;
+    ctx->startMs = StartupTimeline::getInstance().nowMs();
+    pendingInstalls_++;
+    CountInstallCache("miss");
+
+    // concurrent downloads share a single IDBFS sync once the last one lands
+    PluginStore::getInstance().beginBatch();
 
     emscripten_fetch_attr_t attr;
     emscripten_fetch_attr_init(&attr);
@@ -429,48 +540,100 @@ void PluginManager::downloadAndLoadPlugin(LoadablePlugin &plugin)
 {
     if (plugin.name.empty()) return;
     std::string url = GetPluginBaseUrl() + plugin.name;
-    std::filesystem::path output_loc = PLUGIN_DEST + plugin.name;
-    log("Downloading plugin from: " + url + " to " + output_loc.string());
+    std::string localPath = GetPluginDest() + plugin.name;
+    log("Downloading plugin from: " + url + " to " + localPath);
+    pendingInstalls_++;
+    CountInstallCache("miss");
+
+    // download, verify and write on a worker; only the dlopen runs on the main thread
+    TaskPool::getInstance().submit([this, target = plugin, url, localPath]() -> TaskPool::Task {
+        auto& timeline = StartupTimeline::getInstance();
+        double startMs = timeline.nowMs();
+        auto failed = [this]() { installFinished(); };
+
+        std::string data;
+        DigestStream digest(PluginDigest::parse(target.digest).algorithm);
+        CURLcode res = httpGet(url, data, HttpOptions{.digest = &digest});
+        if (res != CURLE_OK) {
+            log(std::string("Download failed: ") + curl_easy_strerror(res), LogLevel::Error);
+            return failed;
+        }
+        timeline.record("download:" + target.name, startMs, timeline.nowMs());
+        CountDownloaded(data.size());
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        log("Curl init failed. Cannot download plugin.");
-        return;
+        // the body was hashed while it arrived, only the finalization is left
+        double verifyStart = timeline.nowMs();
+        if (!verifyDigest(target, digest.finishHex())) {
+            return failed;
+        }
+        timeline.record("verify:" + target.name, verifyStart, timeline.nowMs());
+
+        std::ofstream out(localPath, std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            log("Could not create file: " + localPath, LogLevel::Error);
+            return failed;
+        }
+        out.close();
+        PluginUpdater::getInstance().discardStaged(target.name);
+
+        return [this, name = target.name, localPath]() {
+            if (auto* plugin = findPlugin(name)) {
+                plugin->downloadedPath = localPath;
+                activatePlugin(*plugin);
+            }
+            installFinished();
+        };
+    });
+}
+#endif // EMSCRIPTEN
+
+bool PluginManager::verifyPlugin(const LoadablePlugin &plugin, const char* data, size_t size)
+{
+    return verifyDigest(plugin, digestHex(PluginDigest::parse(plugin.digest).algorithm, data, size));
+}
+
+bool PluginManager::verifyDigest(const LoadablePlugin &plugin, const std::string &hex)
+{
+    PluginDigest expected = PluginDigest::parse(plugin.digest);
+    std::string algorithm = digestAlgorithmName(expected.algorithm);
+    if (expected.empty() || hex != expected.hex) {
+        log(algorithm + " mismatch for plugin: " + plugin.name, LogLevel::Error);
+        return false;
     }
-    std::ofstream out(output_loc, std::ios::binary);
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
-      +[](char* ptr, size_t size, size_t nmemb, void* userdata)->size_t {
-         std::ofstream* fout = (std::ofstream*)userdata;
-         fout->write(ptr, size * nmemb);
-         return size * nmemb;
-      });
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &out);
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-    out.close();
 
-    if (res != CURLE_OK) {
-        log(std::string("Download failed: ") + curl_easy_strerror(res));
-        return;
+    log(algorithm + " match for plugin: " + plugin.name, LogLevel::Debug);
+    return true;
+}
+
+int PluginManager::installPlugin(LoadablePlugin &plugin, const std::string &localPath, const char* data, size_t size)
+{
+    if (plugin.name.empty() || plugin.size == 0 || plugin.digest.empty()) {
+        log("Invalid plugin data.", LogLevel::Error);
+        return -1;
     }
-    plugin.downloadedPath = output_loc.string();
-    loadPlugin(plugin);
+
+    if (!PluginStore::getInstance().write(localPath, data, size)) {
+        log("Could not create file: " + localPath, LogLevel::Error);
+        return -1;
+    }
+
+    plugin.downloadedPath = localPath;
+    PluginUpdater::getInstance().discardStaged(plugin.name);
+    return activatePlugin(plugin);
 }
-#endif // EMSCRIPTEN
 
 int PluginManager::loadPlugin(LoadablePlugin &plugin)
 {
     // validate that the downloaded plugin matches what we expect
-    if (plugin.name.empty() || plugin.size == 0 || plugin.sha1.empty()) {
-        log("Invalid plugin data.");
+    if (plugin.name.empty() || plugin.size == 0 || plugin.digest.empty()) {
+        log("Invalid plugin data.", LogLevel::Error);
         return -1;
     }
 
-    std::string pluginPath = PLUGIN_DEST + plugin.name;
+    std::string pluginPath = GetPluginDest() + plugin.name;
     std::ifstream file(pluginPath, std::ios::binary | std::ios::ate);
     if (!file) {
-        log("Could not open plugin file: " + pluginPath);
+        log("Could not open plugin file: " + pluginPath, LogLevel::Error);
         return -1;
     }
 
@@ -478,32 +641,26 @@ int PluginManager::loadPlugin(LoadablePlugin &plugin)
     file.seekg(0, std::ios::beg);
     std::vector<char> buffer(size);
 
-    // read the file so we can check the sha1
+    // read the file so we can check the digest
     if (!file.read(buffer.data(), size)) {
-        log("Could not read plugin file: " + pluginPath);
+        log("Could not read plugin file: " + pluginPath, LogLevel::Error);
         return -1;
     }
 
     file.close();
 
-    sha1::SHA1 sha;
-    sha.processBytes(buffer.data(), size);
-    unsigned char digest[20];
-    sha.getDigestBytes(digest);
-    std::string sha1Hash;
-    for (size_t i = 0; i < 20; ++i) {
-        sha1Hash += std::format("{:02x}", digest[i]);
-    }
-
-    if (sha1Hash != plugin.sha1) {
-        log("SHA1 mismatch for plugin: " + plugin.name);
+    if (!verifyPlugin(plugin, buffer.data(), static_cast<size_t>(size))) {
+        CountInstallCache("stale");
         return -1;
     }
 
+    CountInstallCache("hit");
+    return activatePlugin(plugin);
+}
 
-    log("SHA1 match for plugin: " + plugin.name);
-
-    int res = loadPluginFromFile(plugin.downloadedPath.string());
+int PluginManager::activatePlugin(LoadablePlugin &plugin)
+{
+    int res = startPlugin(plugin.downloadedPath.string(), plugin.digest, plugin.execution);
     if (res >= 0) {
         plugin.loaded = true;
     }
@@ -511,15 +668,169 @@ int PluginManager::loadPlugin(LoadablePlugin &plugin)
     return res;
 }
 
-int PluginManager::loadPluginFromFile(const std::string &path)
+// owner name used by host services, e.g. "plugin_a" for plugin_a.plugin.wasm
+static std::string PluginOwner(const std::string &path)
+{
+    std::string name = std::filesystem::path(path).filename().string();
+    return name.substr(0, name.find('.'));
+}
+
+// PLUGIN_WORKER_PLUGINS=plugin_a,plugin_b runs those plugins in workers whatever the catalog says
+static bool RunsInWorker(const std::string &owner, const std::string &execution)
+{
+    if (const char* forced = std::getenv("PLUGIN_WORKER_PLUGINS")) {
+        std::string list = std::string(",") + forced + ",";
+        if (list.find("," + owner + ",") != std::string::npos) {
+            return true;
+        }
+    }
+    return execution == "worker";
+}
+
+int PluginManager::startPlugin(const std::string &path, const std::string &digest, const std::string &execution)
+{
+    std::string owner = PluginOwner(path);
+    if (RunsInWorker(owner, execution)) {
+        if (WorkerSupervisor::getInstance().isSupported()) {
+            int res = WorkerSupervisor::getInstance().spawn(owner, path);
+            if (res >= 0) {
+                LoadedPlugins("worker")->add(1);
+            }
+            return res;
+        }
+        log("Worker execution is unavailable here, loading " + owner + " in-process", LogLevel::Warn);
+    }
+    return loadPluginFromFile(path, digest);
+}
+
+#ifdef EMSCRIPTEN
+EM_JS_DEPS(plugin_module_cache, "$loadWebAssemblyModule,$preloadedWasm");
+
+// Compiles a side module off the main thread and instantiates it into emscripten's
+// preloadedWasm table, so the following dlopen only has to link it. Compiled modules
+// are kept in IndexedDB under the plugin path and reused while the digest matches;
+// plugins without a digest are keyed by size and mtime instead of being hashed here.
+// Browsers that cannot serialize WebAssembly.Module simply recompile asynchronously.
+EM_JS(void, precompilePluginModule, (const char* path, const char* digest, void* userData), {
+    var pathStr = UTF8ToString(path);
+    var digestStr = UTF8ToString(digest);
+    if (!digestStr) {
+        try {
+            var st = FS.stat(pathStr);
+            digestStr = 'stat:' + st.size + ':' + (+st.mtime);
+        } catch (e) {
+            // missing file: the compile below reports it
+        }
+    }
+
+    function request(req) {
+        return new Promise(function(resolve, reject) {
+            req.onsuccess = function() { resolve(req.result); };
+            req.onerror = function() { reject(req.error); };
+        });
+    }
+
+    function openCache() {
+        if (typeof indexedDB === 'undefined' || !digestStr) {
+            return Promise.resolve(null);
+        }
+        var req = indexedDB.open('plugin-module-cache', 1);
+        req.onupgradeneeded = function() {
+            req.result.createObjectStore('modules');
+        };
+        return request(req).catch(function() { return null; });
+    }
+
+    var cached = 0;
+    openCache().then(function(db) {
+        var lookup = db
+            ? request(db.transaction('modules', 'readonly').objectStore('modules').get(pathStr)).catch(function() { return undefined; })
+            : Promise.resolve(undefined);
+
+        return lookup.then(function(entry) {
+            if (entry && entry.digest === digestStr && entry.module instanceof WebAssembly.Module) {
+                Module.print('[PluginManager] Module cache hit: ' + pathStr);
+                cached = 1;
+                return entry.module;
+            }
+            return WebAssembly.compile(FS.readFile(pathStr)).then(function(module) {
+                if (db) {
+                    try {
+                        db.transaction('modules', 'readwrite').objectStore('modules')
+                            .put({ digest: digestStr, module: module }, pathStr);
+                    } catch (e) {
+                        // DataCloneError: this browser cannot store compiled modules
+                    }
+                }
+                return module;
+            });
+        });
+    }).then(function(module) {
+        return loadWebAssemblyModule(module, { loadAsync: true, nodelete: true }, pathStr, {});
+    }).then(function(exports) {
+        preloadedWasm[pathStr] = exports;
+        _onPluginModuleReady(userData, 1, cached);
+    }).catch(function(e) {
+        console.error('[PluginManager] Could not compile ' + pathStr + ': ' + e);
+        _onPluginModuleReady(userData, 0, cached);
+    });
+});
+
+struct ModuleLoadCtx {
+    PluginManager* manager;
+    std::string path;
+};
+
+extern "C" EMSCRIPTEN_KEEPALIVE void onPluginModuleReady(void* userData, int compiled, int cached)
+{
+    auto* ctx = reinterpret_cast<ModuleLoadCtx*>(userData);
+    if (Metric* metric = Metrics::getInstance().counter("plugin_module_cache_total",
+            "Compiled plugin modules taken from IndexedDB (hit) or compiled (miss)", Metrics::label("result", cached ? "hit" : "miss"))) {
+        metric->add(1);
+    }
+    ctx->manager->finishPluginLoad(ctx->path, compiled != 0);
+    delete ctx;
+}
+
+int PluginManager::loadPluginFromFile(const std::string &path, const std::string &digest)
+{
+    log("Compiling plugin module: " + path);
+
+    pendingInstalls_++;
+    precompilePluginModule(path.c_str(), digest.c_str(), new ModuleLoadCtx{this, path});
+    return 0;
+}
+
+void PluginManager::finishPluginLoad(const std::string &path, bool compiled)
+{
+    int res = compiled ? openPlugin(path) : -1;
+    if (res < 0) {
+        for (auto& plugin : pluginList_) {
+            if (plugin.downloadedPath == path) {
+                plugin.loaded = false;
+            }
+        }
+    }
+    installFinished();
+}
+#else
+int PluginManager::loadPluginFromFile(const std::string &path, const std::string &)
+{
+    return openPlugin(path);
+}
+#endif
+
+int PluginManager::openPlugin(const std::string &path)
 {
     log("Loading plugin file: " + path);
+    double loadStart = StartupTimeline::getInstance().nowMs();
+    auto openStart = std::chrono::steady_clock::now();
 
 #if defined(_WIN32)
     HMODULE handle = LoadLibraryA(path.c_str());
     if (!handle) {
         DWORD errorCode = GetLastError();
-        log(std::string("LoadLibrary error: ") + std::to_string(errorCode));
+        log(std::string("LoadLibrary error: ") + std::to_string(errorCode), LogLevel::Error);
         return -1;
     }
 
@@ -527,36 +838,55 @@ int PluginManager::loadPluginFromFile(const std::string &path)
     PluginMainFunc func = reinterpret_cast<PluginMainFunc>(GetProcAddress(handle, "pluginMain"));
     if (!func) {
         DWORD errorCode = GetLastError();
-        log(std::string("GetProcAddress error: ") + std::to_string(errorCode));
+        log(std::string("GetProcAddress error: ") + std::to_string(errorCode), LogLevel::Error);
         FreeLibrary(handle);
         return -1;
     }
 #else
     void* handle = dlopen(path.c_str(), RTLD_NOW);
     if (!handle) {
-        log(std::string("dlopen error: ") + dlerror());
+        log(std::string("dlopen error: ") + dlerror(), LogLevel::Error);
         return -1;
     }
     using PluginMainFunc = int (*)();
     PluginMainFunc func = reinterpret_cast<PluginMainFunc>(dlsym(handle, "pluginMain"));
     char* error = dlerror();
     if (error != nullptr) {
-        log(std::string("dlsym error: ") + error);
+        log(std::string("dlsym error: ") + error, LogLevel::Error);
         dlclose(handle);
         return -1;
     }
 #endif
 
+    std::string labels = Metrics::label("plugin", PluginOwner(path));
+    if (Metric* opened = Metrics::getInstance().histogram("plugin_dlopen_seconds", "Time to open a plugin library and resolve pluginMain",
+            Metrics::durationBuckets(), labels)) {
+        opened->observe(SecondsSince(openStart));
+    }
+
+    auto initStart = std::chrono::steady_clock::now();
+    currentPlugin_ = PluginOwner(path);
     int ret = func();
+    currentPlugin_.clear();
+    if (Metric* init = Metrics::getInstance().histogram("plugin_init_seconds", "Time spent in a plugin's pluginMain",
+            Metrics::durationBuckets(), labels)) {
+        init->observe(SecondsSince(initStart));
+    }
     log(std::string("pluginMain returned: ") + std::to_string(ret));
+    StartupTimeline::getInstance().record("load:" + PluginOwner(path), loadStart, StartupTimeline::getInstance().nowMs());
     pluginHandles_.push_back(handle);
+    LoadedPlugins("in-process")->set(static_cast<double>(pluginHandles_.size()));
     return ret;
 }
 
 void PluginManager::unloadAll()
 {
     log("Unloading all plugins...");
+    WorkerSupervisor::getInstance().stopAll();
     renderables_.clear();
+    Scheduler::getInstance().clear();
+    DrawListComposer::getInstance().clear();
+    EventBus::getInstance().clear();
 #if defined(_WIN32)
     for (auto handle : pluginHandles_) {
         FreeLibrary(static_cast<HMODULE>(handle));
@@ -567,5 +897,9 @@ void PluginManager::unloadAll()
     }
 #endif
     pluginHandles_.clear();
+    LoadedPlugins("in-process")->set(0);
+    LoadedPlugins("worker")->set(0);
+    // after dlclose so plugin static destructors can still touch their arenas
+    AllocatorService::getInstance().releaseAll();
     pluginList_.clear();
 }
@@ -0,0 +1,131 @@
+#include "lib/plugin_store.h"
+#include "lib/plugin_manager.h"
+
+#include <fstream>
+#include <utility>
+
+#ifdef EMSCRIPTEN
+#include <emscripten.h>
+
+EM_JS(void, syncPluginStore, (), {
+    FS.syncfs(false, function(err) {
+        if (err) {
+            console.error('[PluginStore] syncfs failed: ' + err);
+        }
+        _onPluginStoreSynced(err ? 0 : 1);
+    });
+});
+
+extern "C" EMSCRIPTEN_KEEPALIVE void onPluginStoreSynced(int ok)
+{
+    PluginStore::getInstance().onSyncComplete(ok != 0);
+}
+#endif
+
+PluginStore& PluginStore::getInstance() {
+    static PluginStore instance;
+    return instance;
+}
+
+void PluginStore::beginBatch()
+{
+    batchDepth_++;
+}
+
+void PluginStore::endBatch(FlushCallback onComplete)
+{
+    if (batchDepth_ > 0) {
+        batchDepth_--;
+    }
+    if (batchDepth_ > 0) {
+        // reported with the sync of the outermost batch
+        if (onComplete) {
+            waiting_.push_back(std::move(onComplete));
+        }
+    } else if (dirtyFiles_ > 0) {
+        flush(std::move(onComplete));
+    } else if (onComplete) {
+        // nothing left to write, but a sync started by an earlier batch may still be running
+        if (syncInFlight_) {
+            inFlight_.push_back(std::move(onComplete));
+        } else {
+            onComplete(true);
+        }
+    }
+}
+
+bool PluginStore::write(const std::string &path, const void* data, size_t size)
+{
+#ifdef EMSCRIPTEN
+    // a single copy from the fetch buffer into the MEMFS node
+    int ok = EM_ASM_INT({
+        try {
+            FS.writeFile(UTF8ToString($0), HEAPU8.subarray($1, $1 + $2));
+            return 1;
+        } catch (e) {
+            console.error('[PluginStore] write failed: ' + e);
+            return 0;
+        }
+    }, path.c_str(), data, size);
+    if (!ok) {
+        return false;
+    }
+#else
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size))) {
+        return false;
+    }
+#endif
+    dirtyFiles_++;
+    if (batchDepth_ == 0) {
+        flush();
+    }
+    return true;
+}
+
+void PluginStore::flush(FlushCallback onComplete)
+{
+    if (onComplete) {
+        waiting_.push_back(std::move(onComplete));
+    }
+
+#ifdef EMSCRIPTEN
+    if (syncInFlight_) {
+        syncQueued_ = true;
+        return;
+    }
+    startSync();
+#else
+    dirtyFiles_ = 0;
+    auto callbacks = std::exchange(waiting_, {});
+    for (auto& callback : callbacks) {
+        callback(true);
+    }
+#endif
+}
+
+#ifdef EMSCRIPTEN
+void PluginStore::startSync()
+{
+    PluginManager::log("Persisting " + std::to_string(dirtyFiles_) + " plugin file(s).");
+    syncInFlight_ = true;
+    dirtyFiles_ = 0;
+    inFlight_ = std::exchange(waiting_, {});
+    syncPluginStore();
+}
+
+void PluginStore::onSyncComplete(bool ok)
+{
+    syncInFlight_ = false;
+    auto callbacks = std::exchange(inFlight_, {});
+    for (auto& callback : callbacks) {
+        callback(ok);
+    }
+
+    // writes or flush requests that arrived during the sync share one more pass
+    if (syncQueued_) {
+        syncQueued_ = false;
+        startSync();
+    }
+}
+#endif
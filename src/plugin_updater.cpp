@@ -0,0 +1,322 @@
+#include "lib/plugin_updater.h"
+#include "lib/plugin_manager.h"
+#include "lib/metrics.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifndef EMSCRIPTEN
+#include "lib/http_client.h"
+#endif
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/resource.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+static const char* STAGED_DIR = "staged";
+// catalog polls are spread over +-20% of the interval
+static constexpr double POLL_JITTER = 0.2;
+// the first poll comes sooner, so updates published during a session are staged within it
+static constexpr std::chrono::seconds FIRST_POLL_DELAY{60};
+
+static std::filesystem::path StagedDir()
+{
+    return std::filesystem::path(PluginManager::installDir()) / STAGED_DIR;
+}
+
+// The updater must never compete with the UI or foreground downloads for CPU or disk.
+static void LowerThreadPriority()
+{
+#if defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+    // no libc wrapper; IOPRIO_WHO_PROCESS with id 0 is the calling thread
+    constexpr int IOPRIO_WHO_PROCESS = 1;
+    constexpr int IOPRIO_CLASS_IDLE = 3;
+    constexpr int IOPRIO_CLASS_SHIFT = 13;
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_THROTTLE);
+#elif defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+}
+
+PluginUpdater& PluginUpdater::getInstance() {
+    static PluginUpdater instance;
+    return instance;
+}
+
+PluginUpdater::~PluginUpdater()
+{
+    stop();
+}
+
+void PluginUpdater::start()
+{
+#ifdef EMSCRIPTEN
+    HOST_LOG(LogLevel::Debug, "Updater", "Background updates are not supported on the web host");
+#else
+    if (const char* interval = std::getenv("PLUGIN_UPDATE_INTERVAL_S")) {
+        interval_ = std::chrono::seconds(std::atol(interval));
+    }
+    if (const char* cap = std::getenv("PLUGIN_UPDATE_MAX_KBPS")) {
+        maxBytesPerSecond_ = std::atoll(cap) * 1024;
+    }
+    if (interval_.count() <= 0) {
+        HOST_LOG(LogLevel::Info, "Updater", "Background updates disabled");
+        return;
+    }
+    if (thread_.joinable()) {
+        return;
+    }
+
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+#endif
+}
+
+void PluginUpdater::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void PluginUpdater::checkNow()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        checkRequested_ = true;
+    }
+    wake_.notify_all();
+}
+
+size_t PluginUpdater::stagedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return staged_.size();
+}
+
+int PluginUpdater::applyStaged()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    std::filesystem::path stagedDir = StagedDir();
+    if (!std::filesystem::is_directory(stagedDir, ec)) {
+        return 0;
+    }
+
+    int applied = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(stagedDir, ec)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::string name = entry.path().filename().string();
+        // leftovers of an interrupted download
+        if (entry.path().extension() == ".part") {
+            std::filesystem::remove(entry.path(), ec);
+            continue;
+        }
+
+        // a rename within the install directory, so the installed file is never half written
+        std::filesystem::path target = std::filesystem::path(PluginManager::installDir()) / name;
+        std::filesystem::rename(entry.path(), target, ec);
+        if (ec) {
+            HOST_LOG(LogLevel::Error, "Updater", "Could not apply staged update " + name + ": " + ec.message());
+            continue;
+        }
+        HOST_LOG(LogLevel::Info, "Updater", "Applied staged update: " + name);
+        staged_.erase(name);
+        applied++;
+    }
+    return applied;
+}
+
+void PluginUpdater::discardStaged(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    if (std::filesystem::remove(StagedDir() / name, ec)) {
+        HOST_LOG(LogLevel::Info, "Updater", "Discarded staged update for " + name + ", a newer version was installed");
+    }
+    staged_.erase(name);
+}
+
+std::chrono::steady_clock::duration PluginUpdater::nextDelay(bool first)
+{
+    std::chrono::duration<double> base = first ? std::min<std::chrono::seconds>(interval_, FIRST_POLL_DELAY) : interval_;
+    std::uniform_real_distribution<double> jitter(1.0 - POLL_JITTER, 1.0 + POLL_JITTER);
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(base * jitter(rng_));
+}
+
+void PluginUpdater::run()
+{
+    LowerThreadPriority();
+    HOST_LOG(LogLevel::Info, "Updater", "Checking for plugin updates every " + std::to_string(interval_.count())
+        + " s, downloads capped at " + std::to_string(maxBytesPerSecond_ / 1024) + " KiB/s");
+
+    bool first = true;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        auto deadline = std::chrono::steady_clock::now() + nextDelay(first);
+        first = false;
+        wake_.wait_until(lock, deadline, [this] { return stopping_ || checkRequested_; });
+        if (stopping_) {
+            break;
+        }
+        checkRequested_ = false;
+
+        lock.unlock();
+        poll();
+        lock.lock();
+    }
+}
+
+#ifndef EMSCRIPTEN
+void PluginUpdater::poll()
+{
+    HttpOptions options{.maxBytesPerSecond = maxBytesPerSecond_, .cancel = &stopping_};
+    std::string response;
+    CURLcode res = httpGet(PluginManager::catalogUrl(), response, options);
+    if (res != CURLE_OK) {
+        HOST_LOG(LogLevel::Debug, "Updater", std::string("Catalog check failed: ") + curl_easy_strerror(res));
+        return;
+    }
+
+    std::vector<LoadablePlugin> catalog;
+    if (!PluginManager::parseCatalog(response, catalog)) {
+        return;
+    }
+
+    for (const auto& plugin : catalog) {
+        if (stopping_) {
+            return;
+        }
+        PluginDigest expected = PluginDigest::parse(plugin.digest);
+        std::string installedPath = PluginManager::installDir() + plugin.name;
+        std::error_code ec;
+        if (plugin.name.empty() || expected.empty() || !std::filesystem::is_regular_file(installedPath, ec)) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = staged_.find(plugin.name);
+            if (it != staged_.end() && it->second == plugin.digest) {
+                continue;
+            }
+        }
+        if (installedDigest(installedPath, expected.algorithm) != plugin.digest) {
+            stage(plugin, installedPath);
+        }
+    }
+}
+
+bool PluginUpdater::stage(const LoadablePlugin &plugin, const std::string &installedPath)
+{
+    PluginDigest expected = PluginDigest::parse(plugin.digest);
+    DigestStream digest(expected.algorithm);
+    // the installed file as poll() saw it; a foreground install changes it
+    Installed seen = installed_[installedPath];
+    HttpOptions options{.digest = &digest, .maxBytesPerSecond = maxBytesPerSecond_, .cancel = &stopping_};
+
+    std::string data;
+    CURLcode res = httpGet(PluginManager::catalogUrl() + "/" + plugin.name, data, options);
+    if (res != CURLE_OK) {
+        if (!stopping_) {
+            HOST_LOG(LogLevel::Warn, "Updater", "Update download failed for " + plugin.name + ": " + curl_easy_strerror(res));
+        }
+        return false;
+    }
+    static Metric* downloaded = Metrics::getInstance().counter("plugin_download_bytes_total", "Plugin bytes downloaded from the registry");
+    downloaded->add(static_cast<double>(data.size()));
+
+    if (digest.finishHex() != expected.hex) {
+        HOST_LOG(LogLevel::Error, "Updater", std::string(digestAlgorithmName(expected.algorithm)) + " mismatch for update of " + plugin.name);
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::path stagedDir = StagedDir();
+    std::filesystem::create_directories(stagedDir, ec);
+    std::filesystem::path partPath = stagedDir / (plugin.name + ".part");
+    {
+        std::ofstream out(partPath, std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            HOST_LOG(LogLevel::Error, "Updater", "Could not write " + partPath.string());
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uintmax_t size = std::filesystem::file_size(installedPath, ec);
+    int64_t mtime = std::filesystem::last_write_time(installedPath, ec).time_since_epoch().count();
+    if (ec || size != seen.size || mtime != seen.mtime) {
+        std::filesystem::remove(partPath, ec);
+        HOST_LOG(LogLevel::Debug, "Updater", "Not staging " + plugin.name + ", it was reinstalled during the download");
+        return false;
+    }
+    std::filesystem::rename(partPath, stagedDir / plugin.name, ec);
+    if (ec) {
+        HOST_LOG(LogLevel::Error, "Updater", "Could not stage " + plugin.name + ": " + ec.message());
+        return false;
+    }
+    staged_[plugin.name] = plugin.digest;
+
+    static Metric* stagedUpdates = Metrics::getInstance().counter("plugin_updates_staged_total", "Plugin updates prefetched for the next start");
+    stagedUpdates->add(1);
+    HOST_LOG(LogLevel::Info, "Updater", "Staged update for " + plugin.name + " (" + std::to_string(data.size())
+        + " bytes), it replaces " + installedPath + " at the next start");
+    return true;
+}
+
+// tagged digest of an installed plugin, rehashed only when its size or mtime changes
+std::string PluginUpdater::installedDigest(const std::string &path, DigestAlgorithm algorithm)
+{
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    int64_t mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) {
+        return "";
+    }
+
+    Installed& installed = installed_[path];
+    PluginDigest cached = PluginDigest::parse(installed.digest);
+    if (installed.size == size && installed.mtime == mtime && !cached.empty() && cached.algorithm == algorithm) {
+        return installed.digest;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    installed = Installed{size, mtime, PluginDigest{algorithm, digestHex(algorithm, data.data(), data.size())}.tagged()};
+    return installed.digest;
+}
+#else
+void PluginUpdater::poll()
+{
+}
+
+bool PluginUpdater::stage(const LoadablePlugin &, const std::string &)
+{
+    return false;
+}
+
+std::string PluginUpdater::installedDigest(const std::string &, DigestAlgorithm)
+{
+    return "";
+}
+#endif
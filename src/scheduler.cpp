@@ -0,0 +1,163 @@
+#include "lib/scheduler.h"
+#include "lib/metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <imgui.h>
+
+Scheduler& Scheduler::getInstance() {
+    static Scheduler instance;
+    return instance;
+}
+
+Scheduler::Handle Scheduler::registerTick(const std::string &owner, double rateHz, TickFunc func)
+{
+    Handle handle = nextHandle_++;
+    double period = rateHz > 0.0 ? 1.0 / rateHz : 0.0;
+    // the first run happens on the next update, nextDue/lastRun are fixed up there
+    ticks_.push_back(Tick{handle, owner, period, 0.0, -1.0, std::move(func)});
+    return handle;
+}
+
+Scheduler::Handle Scheduler::registerDraw(const std::string &owner, const std::string &label, DrawFunc func)
+{
+    Handle handle = nextHandle_++;
+    draws_.push_back(Draw{handle, owner, label, std::move(func)});
+    requestRedraw();
+    return handle;
+}
+
+void Scheduler::remove(Handle handle)
+{
+    std::erase_if(ticks_, [handle](const Tick& tick) { return tick.handle == handle; });
+    std::erase_if(draws_, [handle](const Draw& draw) { return draw.handle == handle; });
+}
+
+void Scheduler::clear()
+{
+    ticks_.clear();
+    draws_.clear();
+}
+
+void Scheduler::requestRedraw()
+{
+    redrawRequested_.store(true, std::memory_order_relaxed);
+}
+
+bool Scheduler::consumeRedrawRequest()
+{
+    return redrawRequested_.exchange(false, std::memory_order_relaxed);
+}
+
+void Scheduler::runDueTicks(double nowSeconds)
+{
+    // ticks may register or remove ticks, so walk a snapshot of the handles;
+    // ticks registered here first run on the next update
+    std::vector<Handle> handles;
+    handles.reserve(ticks_.size());
+    for (const auto& tick : ticks_) {
+        handles.push_back(tick.handle);
+    }
+
+    for (Handle handle : handles) {
+        auto it = std::find_if(ticks_.begin(), ticks_.end(), [handle](const Tick& tick) { return tick.handle == handle; });
+        if (it == ticks_.end()) {
+            continue;
+        }
+        Tick& tick = *it;
+        if (tick.lastRun < 0.0) {
+            tick.lastRun = nowSeconds;
+            tick.nextDue = nowSeconds;
+        }
+        if (nowSeconds < tick.nextDue) {
+            continue;
+        }
+
+        double dt = nowSeconds - tick.lastRun;
+        tick.lastRun = nowSeconds;
+        tick.nextDue += tick.period;
+        // don't try to catch up on missed periods after a stall
+        if (tick.nextDue <= nowSeconds) {
+            tick.nextDue = nowSeconds + tick.period;
+        }
+
+        TickFunc func = tick.func;
+        if (!profiling_) {
+            func(dt);
+            continue;
+        }
+
+        std::string owner = tick.owner;
+        auto start = std::chrono::steady_clock::now();
+        func(dt);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        auto& cost = costs_[owner];
+        cost.ticks++;
+        cost.tickMs += ms;
+        frameMs_[owner] += ms;
+    }
+}
+
+void Scheduler::drawAll()
+{
+    // same as runDueTicks: draw functions may register or remove draws
+    std::vector<Handle> handles;
+    handles.reserve(draws_.size());
+    for (const auto& draw : draws_) {
+        handles.push_back(draw.handle);
+    }
+
+    for (Handle handle : handles) {
+        auto it = std::find_if(draws_.begin(), draws_.end(), [handle](const Draw& draw) { return draw.handle == handle; });
+        if (it == draws_.end()) {
+            continue;
+        }
+        // copies, since the entry may be gone once func returns
+        Draw draw = *it;
+        auto start = std::chrono::steady_clock::now();
+        if (ImGui::Begin(draw.label.c_str())) {
+            draw.func();
+        }
+        ImGui::End();
+        if (profiling_) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            costs_[draw.owner].drawMs += ms;
+            frameMs_[draw.owner] += ms;
+        }
+    }
+
+    for (const auto& [owner, ms] : frameMs_) {
+        auto& metric = frameMetrics_[owner];
+        if (!metric) {
+            metric = Metrics::getInstance().histogram("plugin_frame_seconds", "Time a plugin spent in ticks and draws per frame",
+                Metrics::durationBuckets(), Metrics::label("plugin", owner));
+        }
+        if (metric) {
+            metric->observe(ms / 1000.0);
+        }
+    }
+    frameMs_.clear();
+}
+
+std::vector<Scheduler::OwnerCost> Scheduler::ownerCosts() const
+{
+    std::vector<OwnerCost> result;
+    for (const auto& [owner, cost] : costs_) {
+        result.push_back(cost);
+        result.back().owner = owner;
+    }
+    return result;
+}
+
+double Scheduler::secondsUntilNextTick(double nowSeconds) const
+{
+    if (ticks_.empty()) {
+        return -1.0;
+    }
+
+    double next = ticks_.front().nextDue;
+    for (const auto& tick : ticks_) {
+        next = std::min(next, tick.lastRun < 0.0 ? nowSeconds : tick.nextDue);
+    }
+    return std::max(0.0, next - nowSeconds);
+}
@@ -0,0 +1,92 @@
+#include "lib/shm_ring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+void ShmRing::attach(void* memory, size_t capacity)
+{
+    header_ = static_cast<Header*>(memory);
+    data_ = static_cast<uint8_t*>(memory) + kHeaderSize;
+    capacity_ = capacity;
+    broken_ = false;
+}
+
+void ShmRing::initialize()
+{
+    new (header_) Header();
+    header_->head.store(0, std::memory_order_relaxed);
+    header_->tail.store(0, std::memory_order_release);
+}
+
+bool ShmRing::tryWrite(uint32_t type, const void* data, size_t size)
+{
+    size_t needed = sizeof(Frame) + size;
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    if (needed > capacity_ - (head - tail)) {
+        return false;
+    }
+
+    Frame frame{type, static_cast<uint32_t>(size)};
+    copyIn(head, &frame, sizeof(frame));
+    copyIn(head + sizeof(frame), data, size);
+    header_->head.store(head + needed, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::tryRead(uint32_t &type, std::vector<uint8_t> &payload)
+{
+    if (broken_) {
+        return false;
+    }
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    uint64_t available = head - tail;
+    if (available > capacity_ || available < sizeof(Frame)) {
+        broken_ = true;
+        return false;
+    }
+    Frame frame;
+    copyOut(tail, &frame, sizeof(frame));
+    if (frame.size > available - sizeof(Frame)) {
+        broken_ = true;
+        return false;
+    }
+    type = frame.type;
+    payload.resize(frame.size);
+    copyOut(tail + sizeof(frame), payload.data(), frame.size);
+    header_->tail.store(tail + sizeof(frame) + frame.size, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::empty() const
+{
+    return header_->head.load(std::memory_order_acquire) == header_->tail.load(std::memory_order_acquire);
+}
+
+void ShmRing::copyIn(uint64_t position, const void* data, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    size_t offset = position & (capacity_ - 1);
+    size_t first = std::min(size, capacity_ - offset);
+    std::memcpy(data_ + offset, data, first);
+    std::memcpy(data_, static_cast<const uint8_t*>(data) + first, size - first);
+}
+
+void ShmRing::copyOut(uint64_t position, void* data, size_t size) const
+{
+    if (size == 0) {
+        return;
+    }
+    size_t offset = position & (capacity_ - 1);
+    size_t first = std::min(size, capacity_ - offset);
+    std::memcpy(data, data_ + offset, first);
+    std::memcpy(static_cast<uint8_t*>(data) + first, data_, size - first);
+}
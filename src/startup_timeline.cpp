@@ -0,0 +1,97 @@
+#include "lib/startup_timeline.h"
+#include "lib/logger.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdlib>
+#include <fstream>
+
+StartupTimeline& StartupTimeline::getInstance() {
+    static StartupTimeline instance;
+    return instance;
+}
+
+// main() touches the timeline first, so the origin is (close to) process start
+StartupTimeline::StartupTimeline()
+    : origin_(std::chrono::steady_clock::now())
+{
+    if (const char* path = std::getenv("PLUGIN_STARTUP_REPORT")) {
+        reportPath_ = path;
+        enabled_ = !reportPath_.empty();
+    }
+    const char* exitWhenReady = std::getenv("PLUGIN_STARTUP_EXIT");
+    exitWhenReady_ = enabled_ && exitWhenReady && std::string(exitWhenReady) == "1";
+}
+
+double StartupTimeline::nowMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin_).count();
+}
+
+void StartupTimeline::mark(const std::string &name)
+{
+    if (!enabled_) {
+        return;
+    }
+    double now = nowMs();
+    record(name, now, now);
+}
+
+void StartupTimeline::record(const std::string &name, double startMs, double endMs)
+{
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (readyMs_ < 0.0) {
+        spans_.push_back(Span{name, startMs, endMs});
+    }
+}
+
+bool StartupTimeline::frameRendered(const std::string &host, bool pluginsSettled)
+{
+    if (!enabled_ || readyMs_ >= 0.0) {
+        return false;
+    }
+
+    double now = nowMs();
+    if (firstFrameMs_ < 0.0) {
+        firstFrameMs_ = now;
+    }
+    if (!pluginsSettled) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readyMs_ = now;
+    }
+    writeReport(host);
+    return exitWhenReady_;
+}
+
+void StartupTimeline::writeReport(const std::string &host)
+{
+    nlohmann::json report;
+    report["host"] = host;
+    if (const char* label = std::getenv("PLUGIN_STARTUP_LABEL")) {
+        report["label"] = label;
+    }
+    report["firstFrameMs"] = firstFrameMs_;
+    report["readyMs"] = readyMs_;
+
+    report["spans"] = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& span : spans_) {
+            report["spans"].push_back({{"name", span.name}, {"startMs", span.startMs}, {"endMs", span.endMs}});
+        }
+    }
+
+    std::ofstream out(reportPath_, std::ios::trunc);
+    if (out << report.dump(2) << '\n') {
+        HOST_LOG(LogLevel::Info, "Startup", "Plugins ready " + std::to_string(readyMs_) + " ms after start, report written to " + reportPath_);
+    } else {
+        HOST_LOG(LogLevel::Error, "Startup", "Could not write startup report to " + reportPath_);
+    }
+}
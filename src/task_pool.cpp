@@ -0,0 +1,109 @@
+#include "lib/task_pool.h"
+
+#include <utility>
+
+#if !defined(EMSCRIPTEN) || defined(__EMSCRIPTEN_PTHREADS__)
+#define TASK_POOL_THREADED 1
+#else
+#define TASK_POOL_THREADED 0
+#endif
+
+TaskPool& TaskPool::getInstance() {
+    static TaskPool instance;
+    return instance;
+}
+
+TaskPool::~TaskPool()
+{
+    stop();
+}
+
+bool TaskPool::isThreaded() const
+{
+    return TASK_POOL_THREADED && !workers_.empty();
+}
+
+void TaskPool::start(unsigned workerCount)
+{
+#if TASK_POOL_THREADED
+    if (!workers_.empty()) {
+        return;
+    }
+    stopping_ = false;
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+#else
+    (void)workerCount;
+#endif
+}
+
+void TaskPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        stopping_ = true;
+    }
+    jobsCv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    // results of jobs that finished during shutdown still need to run
+    drainMainThread();
+}
+
+void TaskPool::submit(Job job)
+{
+    if (!isThreaded()) {
+        if (Task continuation = job()) {
+            continuation();
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        jobs_.push_back(std::move(job));
+    }
+    jobsCv_.notify_one();
+}
+
+void TaskPool::post(Task task)
+{
+    std::lock_guard<std::mutex> lock(mainMutex_);
+    mainQueue_.push_back(std::move(task));
+}
+
+void TaskPool::drainMainThread()
+{
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex_);
+        tasks.swap(mainQueue_);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void TaskPool::workerLoop()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex_);
+            jobsCv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        if (Task continuation = job()) {
+            post(std::move(continuation));
+        }
+    }
+}
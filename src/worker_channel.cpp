@@ -0,0 +1,149 @@
+#include "lib/worker_channel.h"
+
+#include <string>
+#include <cstring>
+
+#if PLUGIN_WORKERS_SUPPORTED
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+static constexpr size_t CHANNEL_BYTES = 2 * ShmRing::bytesFor(WorkerChannel::kRingCapacity);
+
+WorkerChannel::~WorkerChannel()
+{
+    close();
+}
+
+#if PLUGIN_WORKERS_SUPPORTED
+
+bool WorkerChannel::create()
+{
+    isHost_ = true;
+    memFd_ = memfd_create("plugin-worker-channel", MFD_CLOEXEC);
+    if (memFd_ < 0 || ftruncate(memFd_, CHANNEL_BYTES) != 0) {
+        close();
+        return false;
+    }
+    hostEventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    workerEventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (hostEventFd_ < 0 || workerEventFd_ < 0 || !map()) {
+        close();
+        return false;
+    }
+
+    toWorker_.initialize();
+    toHost_.initialize();
+    return true;
+}
+
+bool WorkerChannel::attach(int memFd, int hostEventFd, int workerEventFd)
+{
+    isHost_ = false;
+    memFd_ = memFd;
+    hostEventFd_ = hostEventFd;
+    workerEventFd_ = workerEventFd;
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool WorkerChannel::map()
+{
+    mapping_ = mmap(nullptr, CHANNEL_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        return false;
+    }
+    auto* base = static_cast<uint8_t*>(mapping_);
+    toWorker_.attach(base, kRingCapacity);
+    toHost_.attach(base + ShmRing::bytesFor(kRingCapacity), kRingCapacity);
+    return true;
+}
+
+void WorkerChannel::close()
+{
+    if (mapping_) {
+        munmap(mapping_, CHANNEL_BYTES);
+        mapping_ = nullptr;
+    }
+    for (int* fd : {&memFd_, &hostEventFd_, &workerEventFd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool WorkerChannel::send(WorkerMessage type, const void* data, size_t size)
+{
+    ShmRing& ring = isHost_ ? toWorker_ : toHost_;
+    if (!mapping_ || !ring.tryWrite(static_cast<uint32_t>(type), data, size)) {
+        return false;
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(isHost_ ? workerEventFd_ : hostEventFd_, &one, sizeof(one));
+    return true;
+}
+
+bool WorkerChannel::receive(WorkerMessage &type, std::vector<uint8_t> &payload)
+{
+    ShmRing& ring = isHost_ ? toHost_ : toWorker_;
+    uint32_t raw = 0;
+    if (!mapping_ || !ring.tryRead(raw, payload)) {
+        return false;
+    }
+    type = static_cast<WorkerMessage>(raw);
+    return true;
+}
+
+bool WorkerChannel::broken() const
+{
+    return (isHost_ ? toHost_ : toWorker_).broken();
+}
+
+void WorkerChannel::clearSignal()
+{
+    uint64_t count = 0;
+    [[maybe_unused]] ssize_t got = read(inboxEventFd(), &count, sizeof(count));
+}
+
+#else
+
+bool WorkerChannel::create() { return false; }
+bool WorkerChannel::attach(int, int, int) { return false; }
+bool WorkerChannel::map() { return false; }
+void WorkerChannel::close() {}
+bool WorkerChannel::send(WorkerMessage, const void*, size_t) { return false; }
+bool WorkerChannel::receive(WorkerMessage&, std::vector<uint8_t>&) { return false; }
+bool WorkerChannel::broken() const { return false; }
+void WorkerChannel::clearSignal() {}
+
+#endif
+
+void appendWireString(std::vector<uint8_t> &out, const std::string &value)
+{
+    auto size = static_cast<uint32_t>(value.size());
+    const auto* sizeBytes = reinterpret_cast<const uint8_t*>(&size);
+    out.insert(out.end(), sizeBytes, sizeBytes + sizeof(size));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+bool readWireString(const uint8_t* &data, const uint8_t* end, std::string &value)
+{
+    uint32_t size = 0;
+    if (end - data < static_cast<ptrdiff_t>(sizeof(size))) {
+        return false;
+    }
+    std::memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if (end - data < static_cast<ptrdiff_t>(size)) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data), size);
+    data += size;
+    return true;
+}
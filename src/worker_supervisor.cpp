@@ -0,0 +1,272 @@
+#include "lib/worker_supervisor.h"
+#include "lib/draw_list_composer.h"
+#include "lib/scheduler.h"
+#include "lib/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if PLUGIN_WORKERS_SUPPORTED
+#include <csignal>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// restart delay doubles per crash up to the cap; a worker that stayed up for
+// STABLE_SECONDS starts over at the base delay
+static constexpr double RESTART_BASE_SECONDS = 0.5;
+static constexpr double RESTART_MAX_SECONDS = 30.0;
+static constexpr double STABLE_SECONDS = 30.0;
+static constexpr auto SHUTDOWN_GRACE = std::chrono::seconds(1);
+
+static double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+WorkerSupervisor& WorkerSupervisor::getInstance() {
+    static WorkerSupervisor instance;
+    return instance;
+}
+
+WorkerSupervisor::~WorkerSupervisor()
+{
+    stopAll();
+}
+
+#if PLUGIN_WORKERS_SUPPORTED
+
+// plugin_worker is installed next to the host unless PLUGIN_WORKER_PATH says otherwise
+static std::string WorkerExecutable()
+{
+    if (const char* path = std::getenv("PLUGIN_WORKER_PATH")) {
+        return path;
+    }
+    char self[4096];
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len <= 0) {
+        return "plugin_worker";
+    }
+    self[len] = '\0';
+    std::string dir(self);
+    return dir.substr(0, dir.rfind('/') + 1) + "plugin_worker";
+}
+
+int WorkerSupervisor::spawn(const std::string &owner, const std::string &path)
+{
+    auto worker = std::make_unique<Worker>();
+    worker->owner = owner;
+    worker->path = path;
+    if (!launch(*worker)) {
+        return -1;
+    }
+    workers_.push_back(std::move(worker));
+    return 0;
+}
+
+bool WorkerSupervisor::launch(Worker &worker)
+{
+    auto channel = std::make_unique<WorkerChannel>();
+    if (!channel->create()) {
+        HOST_LOG(LogLevel::Error, "Worker", "Failed to create channel for " + worker.owner + ": " + std::strerror(errno));
+        return false;
+    }
+
+    std::string exe = WorkerExecutable();
+    std::string fds = std::to_string(channel->memFd()) + "," + std::to_string(channel->hostEventFd()) + "," + std::to_string(channel->workerEventFd());
+    std::vector<std::string> args = {exe, "--plugin", worker.path, "--owner", worker.owner, "--fds", fds};
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    int inherited[] = {channel->memFd(), channel->hostEventFd(), channel->workerEventFd()};
+    pid_t parent = getpid();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // only async-signal-safe calls until exec
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != parent) {
+            _exit(1);
+        }
+        for (int fd : inherited) {
+            fcntl(fd, F_SETFD, 0);
+        }
+        execv(exe.c_str(), argv.data());
+        _exit(127);
+    }
+    if (pid < 0) {
+        HOST_LOG(LogLevel::Error, "Worker", "fork failed for " + worker.owner + ": " + std::strerror(errno));
+        return false;
+    }
+
+    worker.pid = pid;
+    worker.channel = std::move(channel);
+    worker.startedAt = NowSeconds();
+    worker.restartAt = -1.0;
+    worker.viewports.clear();
+    HOST_LOG(LogLevel::Info, "Worker", "Started " + exe + " for " + worker.owner + " (pid " + std::to_string(pid) + ")");
+    return true;
+}
+
+void WorkerSupervisor::update()
+{
+    double now = NowSeconds();
+    for (auto& worker : workers_) {
+        if (worker->pid > 0) {
+            worker->channel->clearSignal();
+            WorkerMessage type;
+            while (worker->channel->receive(type, scratch_)) {
+                handleMessage(*worker, type, scratch_);
+            }
+            if (worker->channel->broken()) {
+                HOST_LOG(LogLevel::Error, "Worker", "Corrupt channel from " + worker->owner + ", restarting it");
+                kill(worker->pid, SIGKILL);
+                reap(*worker, true);
+                continue;
+            }
+            syncViewports(*worker);
+            reap(*worker);
+        } else if (worker->restartAt >= 0.0 && now >= worker->restartAt) {
+            if (!launch(*worker)) {
+                worker->restartAt = now + RESTART_MAX_SECONDS;
+            }
+        }
+    }
+}
+
+void WorkerSupervisor::handleMessage(Worker &worker, WorkerMessage type, const std::vector<uint8_t> &payload)
+{
+    switch (type) {
+    case WorkerMessage::Ready: {
+        int32_t result = 0;
+        if (payload.size() == sizeof(result)) {
+            std::memcpy(&result, payload.data(), sizeof(result));
+        }
+        HOST_LOG(LogLevel::Info, "Worker", worker.owner + " ready, pluginMain returned " + std::to_string(result));
+        break;
+    }
+    case WorkerMessage::Log: {
+        LogRecord record;
+        if (payload.size() == sizeof(record)) {
+            std::memcpy(&record, payload.data(), sizeof(record));
+            record.tag[sizeof(record.tag) - 1] = '\0';
+            record.message[sizeof(record.message) - 1] = '\0';
+            Logger::getInstance().write(record.level, record.tag, record.message);
+        }
+        break;
+    }
+    case WorkerMessage::RequestRedraw:
+        Scheduler::getInstance().requestRedraw();
+        break;
+    case WorkerMessage::DrawFrame: {
+        const uint8_t* data = payload.data();
+        const uint8_t* end = data + payload.size();
+        std::string label;
+        DrawBuffer buffer;
+        if (readWireString(data, end, label) && buffer.deserialize(data, end - data)) {
+            worker.viewports.try_emplace(label, ImVec2(-1, -1));
+            DrawListComposer::getInstance().submitRemote(worker.owner, label, std::move(buffer));
+        } else {
+            HOST_LOG(LogLevel::Warn, "Worker", "Dropped malformed frame from " + worker.owner);
+        }
+        break;
+    }
+    default:
+        HOST_LOG(LogLevel::Warn, "Worker", "Unexpected message from " + worker.owner);
+        break;
+    }
+}
+
+void WorkerSupervisor::syncViewports(Worker &worker)
+{
+    auto& composer = DrawListComposer::getInstance();
+    for (auto& [label, sent] : worker.viewports) {
+        ImVec2 available = composer.availableFor(worker.owner, label);
+        if (available.x == sent.x && available.y == sent.y) {
+            continue;
+        }
+
+        std::vector<uint8_t> payload;
+        appendWireString(payload, label);
+        const auto* size = reinterpret_cast<const uint8_t*>(&available);
+        payload.insert(payload.end(), size, size + sizeof(available));
+        if (worker.channel->send(WorkerMessage::Viewport, payload.data(), payload.size())) {
+            sent = available;
+        }
+    }
+}
+
+void WorkerSupervisor::reap(Worker &worker, bool block)
+{
+    int status = 0;
+    if (waitpid(worker.pid, &status, block ? 0 : WNOHANG) != worker.pid) {
+        return;
+    }
+
+    std::string reason = WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+        : "exited with status " + std::to_string(WEXITSTATUS(status));
+
+    double now = NowSeconds();
+    if (now - worker.startedAt >= STABLE_SECONDS) {
+        worker.restarts = 0;
+    }
+    double delay = std::min(RESTART_BASE_SECONDS * double(1u << std::min(worker.restarts, 16u)), RESTART_MAX_SECONDS);
+    worker.restarts++;
+    worker.restartAt = now + delay;
+    worker.pid = -1;
+    worker.channel.reset();
+
+    // the last frames stay on screen until the restarted worker replaces them
+    HOST_LOG(LogLevel::Warn, "Worker", worker.owner + " " + reason + ", restarting in " + std::to_string(delay) + " s");
+}
+
+void WorkerSupervisor::stopAll()
+{
+    for (auto& worker : workers_) {
+        if (worker->pid > 0) {
+            worker->channel->send(WorkerMessage::Shutdown);
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + SHUTDOWN_GRACE;
+    for (auto& worker : workers_) {
+        while (worker->pid > 0) {
+            if (waitpid(worker->pid, nullptr, WNOHANG) == worker->pid) {
+                worker->pid = -1;
+            } else if (std::chrono::steady_clock::now() >= deadline) {
+                kill(worker->pid, SIGKILL);
+                waitpid(worker->pid, nullptr, 0);
+                worker->pid = -1;
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    }
+    workers_.clear();
+}
+
+#else
+
+int WorkerSupervisor::spawn(const std::string &owner, const std::string &)
+{
+    HOST_LOG(LogLevel::Warn, "Worker", "Worker execution is not supported on this platform: " + owner);
+    return -1;
+}
+
+bool WorkerSupervisor::launch(Worker &) { return false; }
+void WorkerSupervisor::update() {}
+void WorkerSupervisor::handleMessage(Worker &, WorkerMessage, const std::vector<uint8_t> &) {}
+void WorkerSupervisor::syncViewports(Worker &) {}
+void WorkerSupervisor::reap(Worker &, bool) {}
+void WorkerSupervisor::stopAll() { workers_.clear(); }
+
+#endif
@@ -0,0 +1,152 @@
+// plugin_worker: hosts a single plugin out of process for the host's WorkerSupervisor.
+//
+//   plugin_worker --plugin <path> --fds <memfd>,<host eventfd>,<worker eventfd>
+//
+// The plugin's ticks and prepared draws run here; frames, log records and redraw
+// requests go back to the host over the shared-memory WorkerChannel.
+//
+//   plugin_worker --probe <path>
+//
+// Prints how many microseconds dlopen takes to map the plugin and bind all of its
+// relocations against the host symbols, without running pluginMain. The build
+// uses it for the load time in cmake/plugin_report.cmake.
+#include "lib/plugin_manager.h"
+#include "lib/worker_channel.h"
+#include "lib/event_bus.h"
+
+#include <dlfcn.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// prepared draws are polled at this rate, ticks run at their own
+static constexpr double FRAME_SECONDS = 1.0 / 60.0;
+
+static double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static int ProbeLoad(const char* path)
+{
+    auto start = std::chrono::steady_clock::now();
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (!handle) {
+        std::fprintf(stderr, "plugin_worker: %s\n", dlerror());
+        return 1;
+    }
+    std::printf("%lld\n", static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    dlclose(handle);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "--probe") == 0) {
+        return ProbeLoad(argv[2]);
+    }
+
+    std::string pluginPath;
+    int fds[3] = {-1, -1, -1};
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--plugin") == 0) {
+            pluginPath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--fds") == 0) {
+            std::sscanf(argv[i + 1], "%d,%d,%d", &fds[0], &fds[1], &fds[2]);
+        }
+    }
+    if (pluginPath.empty() || fds[0] < 0) {
+        std::fprintf(stderr, "usage: %s --plugin <path> --fds <mem>,<host>,<worker>\n       %s --probe <path>\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    WorkerChannel channel;
+    if (!channel.attach(fds[0], fds[1], fds[2])) {
+        std::perror("plugin_worker: attach");
+        return 1;
+    }
+
+    Logger::getInstance().setForwarder([&channel](const LogRecord& record) {
+        channel.send(WorkerMessage::Log, &record, sizeof(record));
+    });
+
+    int32_t result = PluginManager::getInstance().openPlugin(pluginPath);
+    Logger::getInstance().pump();
+    channel.send(WorkerMessage::Ready, &result, sizeof(result));
+    if (result < 0) {
+        return 1;
+    }
+
+    auto& scheduler = Scheduler::getInstance();
+    auto& composer = DrawListComposer::getInstance();
+
+    // frames the ring had no room for; only the newest per label is kept
+    std::map<std::string, std::vector<uint8_t>> pending;
+    // labels whose frames outgrew the ring, reported once each
+    std::set<std::string> oversized;
+    std::vector<uint8_t> payload;
+    bool running = true;
+
+    while (running) {
+        double now = NowSeconds();
+        scheduler.runDueTicks(now);
+        EventBus::getInstance().dispatch();
+
+        composer.prepareNow([&pending, &oversized](const std::string& label, const DrawBuffer& buffer) {
+            auto& frame = pending[label];
+            frame.clear();
+            appendWireString(frame, label);
+            buffer.serialize(frame);
+            if (frame.size() > WorkerChannel::kMaxPayload) {
+                if (oversized.insert(label).second) {
+                    HOST_LOG(LogLevel::Error, "Worker", "Dropping frames for " + label + ": "
+                        + std::to_string(frame.size()) + " bytes do not fit in the channel");
+                }
+                pending.erase(label);
+            }
+        });
+        std::erase_if(pending, [&channel](const auto& entry) {
+            return channel.send(WorkerMessage::DrawFrame, entry.second.data(), entry.second.size());
+        });
+
+        if (scheduler.consumeRedrawRequest()) {
+            channel.send(WorkerMessage::RequestRedraw);
+        }
+        Logger::getInstance().pump();
+
+        double wait = scheduler.secondsUntilNextTick(NowSeconds());
+        wait = wait < 0.0 ? FRAME_SECONDS : std::min(wait, FRAME_SECONDS);
+        pollfd inbox{channel.inboxEventFd(), POLLIN, 0};
+        poll(&inbox, 1, static_cast<int>(wait * 1000.0));
+        channel.clearSignal();
+
+        WorkerMessage type;
+        while (channel.receive(type, payload)) {
+            if (type == WorkerMessage::Shutdown) {
+                running = false;
+            } else if (type == WorkerMessage::Viewport) {
+                const uint8_t* data = payload.data();
+                const uint8_t* end = data + payload.size();
+                std::string label;
+                ImVec2 available;
+                if (readWireString(data, end, label) && end - data == sizeof(available)) {
+                    std::memcpy(&available, data, sizeof(available));
+                    composer.setAvailable(label, available);
+                }
+            }
+        }
+    }
+
+    PluginManager::getInstance().unloadAll();
+    Logger::getInstance().pump();
+    return 0;
+}